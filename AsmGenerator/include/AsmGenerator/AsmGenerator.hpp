@@ -1,6 +1,7 @@
 #ifndef asmgenerator_hpp
 #define asmgenerator_hpp
 #include "Tac/Tac.hpp"
+#include "Tac/Cfg.hpp"
 #include "Register.hpp"
 #include <vector>
 #include <ostream>
@@ -8,6 +9,7 @@
 #include <tuple>
 #include <span>
 #include <utility>
+#include <cstdint>
 namespace assembly
 {
 	namespace tac = intermediate_rep::tac;
@@ -20,6 +22,21 @@ namespace assembly
 		int nextUse = -1;
 	};
 
+	// Codegen state of the variables of the function being generated, one entry per Variable::index.
+	// Kept here instead of on the variables, so the symbol tables are never written by the backend.
+	struct VariableStates
+	{
+		std::vector<std::uint32_t> registers;	// bit per Register that holds the current value
+		std::vector<std::uint8_t> inMemory;		// the current value is also in the stack slot
+		std::vector<std::uint8_t> live;
+		std::vector<int> nextUse;				// -1 means no next use
+		std::vector<int> stackSlot;				// offset from the base pointer, 0 until it has one
+		std::vector<std::uint32_t> epoch;		// block the other entries are valid for
+
+		void resize(std::size_t size);
+		void clear();
+	};
+
 	class AsmGenerator
 	{
 	public:
@@ -29,7 +46,11 @@ namespace assembly
 
 		std::vector<BasicBlock> getBasicBlocks(tac::Function& function);
 
-		std::vector<std::tuple<LiveUseInfo,LiveUseInfo,LiveUseInfo>> nextUseLive(BasicBlock& basicBlock, intermediate_rep::SymbolTable& sym_table);
+		// Blocks of cfg in the order of the code
+		std::vector<BasicBlock> getBasicBlocks(const tac::Cfg& cfg);
+
+		// Starts a new epoch, so every variable enters the block in its entry state
+		std::vector<std::tuple<LiveUseInfo,LiveUseInfo,LiveUseInfo>> nextUseLive(BasicBlock& basicBlock);
 
 		friend class ArithmeticVisitor;
 		friend class ReturnVisitor;
@@ -43,17 +64,25 @@ namespace assembly
 
 		void store(intermediate_rep::SymbolTable::Variable*);
 
+		// Stores the named variables whose current value is only in a register
+		void storeNamed();
+
 		void copyOrDrop(intermediate_rep::SymbolTable::Variable*, LiveUseInfo& info);
 
 		void overwriteWithResult(intermediate_rep::SymbolTable::Variable*, assembly::RegisterDescriptor*);
 
 		void allocateRegisters(tac::Quadruple& quad, std::tuple<LiveUseInfo, LiveUseInfo, LiveUseInfo>& info);
 
-		void computeParameterOffsets(intermediate_rep::SymbolTable& para_scope);
+		void computeParameterOffsets(intermediate_rep::SymbolTable::Function& function);
 
 		void computeLocalOffset(intermediate_rep::SymbolTable::Variable*);
 
-		void resetSymbolTable(intermediate_rep::SymbolTable& sym_table);
+		// Index of var in variables, its entries are reset to the block entry state
+		// if it was last touched in an earlier epoch
+		std::uint32_t state(intermediate_rep::SymbolTable::Variable* var);
+
+		// Register holding the current value of a variable
+		assembly::RegisterDescriptor* firstRegister(std::uint32_t registers);
 
 		std::vector<tac::Function>& functions;
 
@@ -62,6 +91,11 @@ namespace assembly
 		std::ostream& os;
 
 		int offset = 8;
+
+		VariableStates variables;
+
+		// Bumped per basic block instead of resetting all variables
+		std::uint32_t epoch = 0;
  	
  	};
  	void printLiveNessRanges(std::ostream& os, BasicBlock& basicBlock,std::vector<std::tuple<LiveUseInfo,LiveUseInfo,LiveUseInfo>>& info);
@@ -8,6 +8,9 @@
 #include <algorithm>
 #include <string_view>
 #include <sstream>
+#include <bit>
+#include <cstdint>
+#include <cctype>
 
 namespace assembly
 {
@@ -19,30 +22,37 @@ namespace assembly
 		{intermediate_rep::SymbolTable::Variable::Type::Str, 8},
 	};
 
+	constexpr std::uint32_t bit(Register reg)
+	{
+		return 1u << static_cast<unsigned>(reg);
+	}
+
 	const std::map<int, std::string_view> datatypes
 	{
 		{1, "BYTE"},
 		{8, "QWORD"}
 	};
 
+	// Name of the low size bytes of reg: AL, AX, EAX, RAX or R8B, R8W, R8D, R8
 	std::string sub_register(assembly::Register reg, int size)
 	{
 		std::stringstream ss;
 		ss << reg;
 		auto s = ss.str();
-		auto center_char = s[1];
+		auto numbered = std::isdigit(static_cast<unsigned char>(s[1])) != 0;
+		auto legacy = s.substr(1);	// AX, BX, SI, ...
 		switch (size)
 		{
 		case 1:
-			return center_char + "L";
+			return numbered ? s + "B" : (legacy.ends_with('X') ? legacy.substr(0, 1) : legacy) + "L";
 		case 2:
-			return center_char + "H";
+			return numbered ? s + "W" : legacy;
 		case 4:
-			return "E" + std::to_string(center_char) + "X";
+			return numbered ? s + "D" : "E" + legacy;
 		case 8:
-			return "R" + std::to_string(center_char) + "X";
+			return s;
 		default:
-			throw std::runtime_error("");
+			throw std::runtime_error("No register of " + std::to_string(size) + " bytes");
 
 		}
 	}
@@ -52,26 +62,16 @@ namespace assembly
 	{}
 
 	std::vector<BasicBlock> AsmGenerator::getBasicBlocks(tac::Function& function)
+	{
+		return getBasicBlocks(tac::Cfg{ function });
+	}
+
+	std::vector<BasicBlock> AsmGenerator::getBasicBlocks(const tac::Cfg& cfg)
 	{
 		std::vector<BasicBlock> basicBlocks;
-		auto blockBegin = function.tac.begin();
-		auto blockEnd = blockBegin;
-		while (blockBegin != function.tac.end())
+		for (auto id : cfg.layout())
 		{
-			while (blockEnd != function.tac.end())
-			{
-				if (blockEnd != blockBegin && blockEnd->label.size() != 0)
-					break;
-
-				if (tac::isJump(blockEnd->instr))
-				{
-					++blockEnd;
-					break;
-				}
-				++blockEnd;
-			}
-			basicBlocks.push_back({ blockBegin, blockEnd });
-			blockBegin = blockEnd;
+			basicBlocks.push_back(cfg.code(id));
 		}
 		return basicBlocks;
 	}
@@ -82,30 +82,53 @@ namespace assembly
 		for (auto& function : functions)
 		{
 			offset = 8;
-			computeParameterOffsets(*function.sym_entry->parameter_scope);
-			auto basicBlocks = getBasicBlocks(function);
+			variables.clear();
+			variables.resize(function.variables.size());
+			computeParameterOffsets(*function.sym_entry);
+			// Named variables get their stack slot up front, every block loads them from there
+			for (auto var : function.variables)
+			{
+				if (!var->isTemp && variables.stackSlot[state(var)] == 0)
+				{
+					computeLocalOffset(var);
+				}
+			}
+			tac::Cfg cfg{ function };
 			// Function Label
 			os << function.sym_entry->name << ":\n";
 			os << "push rbp\nmov rbp, rsp\n";
-			for (auto block : basicBlocks)
+			for (auto id : cfg.layout())
 			{
-				resetSymbolTable(*function.sym_entry->parameter_scope);
+				auto block = cfg.code(id);
 				registerState.clear();
-				auto use = nextUseLive(block, *function.sym_entry->parameter_scope);
+				auto use = nextUseLive(block);
 
+				// The next block expects named variables in memory, so they are stored
+				// before a jump leaves the block or after its last instruction
+				auto last = static_cast<int>(block.size()) - 1;
+				auto leaves = tac::isJump(block[last].instr);
 				for (int i = 0; i < block.size(); ++i)
 				{
+					if (i == last && leaves && block[i].instr != tac::InstructionType::Return)
+					{
+						storeNamed();
+					}
 					allocateRegisters(block[i], use[i]);
 				}
+				if (!leaves)
+				{
+					storeNamed();
+				}
 			}
 		}
 	}
 
-	std::vector<std::tuple<LiveUseInfo, LiveUseInfo, LiveUseInfo>> AsmGenerator::nextUseLive(BasicBlock& basicBlock, intermediate_rep::SymbolTable& sym_table)
+	std::vector<std::tuple<LiveUseInfo, LiveUseInfo, LiveUseInfo>> AsmGenerator::nextUseLive(BasicBlock& basicBlock)
 	{
 		using Variable = intermediate_rep::SymbolTable::Variable;
 
-		resetSymbolTable(sym_table);
+		// Variables start the block in their entry state, see state()
+		++epoch;
 
 		std::vector<std::tuple<LiveUseInfo, LiveUseInfo, LiveUseInfo>> info(basicBlock.size());
 
@@ -115,53 +138,53 @@ namespace assembly
 
 			if (std::holds_alternative<Variable*>(quad.result))
 			{
-				auto var = std::get<Variable*>(quad.result);
+				auto var = state(std::get<Variable*>(quad.result));
 				auto& [live, nextUse] = std::get<0>(info[i]);
-				live = var->live;
-				nextUse = var->nextUse;
-				var->live = false;
-				var->nextUse = -1;
+				live = variables.live[var];
+				nextUse = variables.nextUse[var];
+				variables.live[var] = false;
+				variables.nextUse[var] = -1;
 			}
 
 			if (std::holds_alternative<Variable*>(quad.arg1))
 			{
-				auto var = std::get<Variable*>(quad.arg1);
+				auto var = state(std::get<Variable*>(quad.arg1));
 				auto& [live, nextUse] = std::get<1>(info[i]);
-				live = var->live;
-				nextUse = var->nextUse;
+				live = variables.live[var];
+				nextUse = variables.nextUse[var];
 
-				var->live = true;
-				var->nextUse = i;
+				variables.live[var] = true;
+				variables.nextUse[var] = i;
 			}
 
 			if (std::holds_alternative<Variable*>(quad.arg2))
 			{
-				auto var = std::get<Variable*>(quad.arg2);
+				auto var = state(std::get<Variable*>(quad.arg2));
 				auto& [live, nextUse] = std::get<2>(info[i]);
-				live = var->live;
-				nextUse = var->nextUse;
-				var->live = true;
-				var->nextUse = i;
+				live = variables.live[var];
+				nextUse = variables.nextUse[var];
+				variables.live[var] = true;
+				variables.nextUse[var] = i;
 			}
 		}
 
 		return info;
 	}
 
+	assembly::RegisterDescriptor* AsmGenerator::firstRegister(std::uint32_t registers)
+	{
+		return &registerState.registers.at(static_cast<Register>(std::countr_zero(registers)));
+	}
+
 	assembly::RegisterDescriptor* AsmGenerator::load(intermediate_rep::SymbolTable::Variable* var)
 	{
-		// See if variable is already inside a register
-		auto reg = std::find_if(var->variableDescriptor.begin(), var->variableDescriptor.end(), [](auto& addr) {
-			if (auto regDesc = std::get_if<assembly::RegisterDescriptor*>(&addr))
-				return true;
-			return false;
-			}
-		);
+		auto v = state(var);
 
-		if (reg != var->variableDescriptor.end())
+		// See if variable is already inside a register
+		if (variables.registers[v] != 0)
 		{
 			// the most recent version is already inside a register 
-			return std::get<assembly::RegisterDescriptor*>(*reg);
+			return firstRegister(variables.registers[v]);
 		}
 
 		// get a free register
@@ -175,7 +198,7 @@ namespace assembly
 			descrPtr->content.push_back(var);
 
 			// Variable now inside register and memory
-			var->variableDescriptor.push_back(descrPtr);
+			variables.registers[v] |= bit(descrPtr->reg);
 
 			if (sizeOf.at(var->type) < 8)
 			{
@@ -186,7 +209,7 @@ namespace assembly
 				os << "mov ";
 			}
 
-			os << sub_register(descrPtr->reg, sizeOf.at(var->type)) << ", [rbp + " << var->basePointerOffset << "]\n";
+			os << sub_register(descrPtr->reg, sizeOf.at(var->type)) << ", [rbp + " << variables.stackSlot[v] << "]\n";
 
 			return descrPtr;
 		}
@@ -194,75 +217,63 @@ namespace assembly
 		{
 			// There is no free register available
 			// decide which variable to drop
-			throw std::runtime_error("");
+			throw std::runtime_error("No free register, spilling is not implemented");
 		}
 	}
 
 	void AsmGenerator::store(intermediate_rep::SymbolTable::Variable* var)
 	{
-		intermediate_rep::SymbolTable::Variable::Memory* mem = nullptr;
-		assembly::RegisterDescriptor* descr = nullptr;
-
-		for (auto& addr : var->variableDescriptor)
-		{
-			if (auto descrPtrPtr = std::get_if<assembly::RegisterDescriptor*>(&addr))
-			{
-				descr = *descrPtrPtr;
-			}
-			else
-			{
-				mem = &std::get<intermediate_rep::SymbolTable::Variable::Memory>(addr);
-			}
-		}
+		auto v = state(var);
 
-		if (!descr)
+		if (variables.registers[v] == 0)
 		{
 			throw std::runtime_error("Trying to store variable that is not in a register");
 		}
 
-		if (mem)
+		if (variables.inMemory[v])
 		{
 			// No need to store variable because the most recent version is also in memory
 			return;
 		}
 
 		// Check if variable has a memory address
-		if (var->basePointerOffset == 0)
+		if (variables.stackSlot[v] == 0)
 		{
 			// Compute memory address
 			computeLocalOffset(var);
 		}
 
-		os << "mov [RBP + " << var->basePointerOffset << "], " << sub_register(descr->reg,sizeOf.at(var->type))<< '\n';
+		os << "mov [RBP + " << variables.stackSlot[v] << "], " << sub_register(firstRegister(variables.registers[v])->reg, sizeOf.at(var->type)) << '\n';
 
 		// most recent version is now also in memory, but also in the register
-		var->variableDescriptor.push_back(intermediate_rep::SymbolTable::Variable::Memory{});
+		variables.inMemory[v] = true;
+	}
+
+	void AsmGenerator::storeNamed()
+	{
+		for (auto& [reg, descr] : registerState.registers)
+		{
+			for (auto var : descr.content)
+			{
+				auto v = state(var);
+				if (!var->isTemp && variables.registers[v] != 0 && !variables.inMemory[v])
+				{
+					store(var);
+				}
+			}
+		}
 	}
 
 	void AsmGenerator::copyOrDrop(intermediate_rep::SymbolTable::Variable* var, LiveUseInfo& info)
 	{
+		auto v = state(var);
+
 		// is the variable inside a register?
-		auto iterReg = std::find_if(var->variableDescriptor.begin(), var->variableDescriptor.end(), [](auto& variant) {
-			if (std::holds_alternative<assembly::RegisterDescriptor*>(variant))
-				return true;
-			return false;
-			});
-
-		// it's not in a register
-		if (iterReg == var->variableDescriptor.end())
+		if (variables.registers[v] == 0)
 			throw std::runtime_error("Variable not inside register");
 
-
 		// Is the most recent version in memory?
-		auto iter = std::find_if(var->variableDescriptor.begin(), var->variableDescriptor.end(), [](auto& variant) {
-			if (std::holds_alternative<intermediate_rep::SymbolTable::Variable::Memory>(variant))
-			{
-				return true;
-			}
-			return false;
-			});
-
-		if (iter != var->variableDescriptor.end())
+		if (variables.inMemory[v])
 		{
 			// current value in memory and register
 
@@ -270,8 +281,8 @@ namespace assembly
 			{
 				// variable is still needed later on
 				auto descr = registerState.getEmptyRegister();
-
-				var->variableDescriptor.push_back(descr);
+				os << "mov " << descr->reg << ", " << firstRegister(variables.registers[v])->reg << '\n';
+				variables.registers[v] |= bit(descr->reg);
 				descr->content.emplace_back(var);
 				// current value now in 2 registers and memory
 			}
@@ -286,14 +297,14 @@ namespace assembly
 			{
 				// value still used later on
 				auto descr = registerState.getEmptyRegister();
-				os << "mov " << descr->reg << ", " << (std::get<assembly::RegisterDescriptor*>(*iterReg))->reg << '\n';
-				var->variableDescriptor.push_back(descr);
+				os << "mov " << descr->reg << ", " << firstRegister(variables.registers[v])->reg << '\n';
+				variables.registers[v] |= bit(descr->reg);
 				descr->content.emplace_back(var);
 
 			}
 			else
 			{
-				if (!var->name.starts_with("__"))
+				if (!var->isTemp)
 				{
 					store(var);
 				}
@@ -304,19 +315,14 @@ namespace assembly
 
 	void AsmGenerator::overwriteWithResult(intermediate_rep::SymbolTable::Variable* var, assembly::RegisterDescriptor* descr)
 	{
-		for (auto& addr : descr->content)
+		for (auto addr : descr->content)
 		{
-			addr->variableDescriptor.erase(std::remove_if(addr->variableDescriptor.begin(), addr->variableDescriptor.end(), [descr](auto& variant) {
-				if (std::holds_alternative<assembly::RegisterDescriptor*>(variant) && std::get<assembly::RegisterDescriptor*>(variant) == descr)
-				{
-					return true;
-				}
-				return false;
-				}));
+			variables.registers[state(addr)] &= ~bit(descr->reg);
 		}
 		descr->content.clear();
-		var->variableDescriptor.clear();
-		var->variableDescriptor.emplace_back(descr);
+		auto v = state(var);
+		variables.registers[v] = bit(descr->reg);
+		variables.inMemory[v] = false;
 		descr->content.push_back(var);
 	}
 
@@ -586,8 +592,9 @@ namespace assembly
 		{
 			auto descrArg2 = gen.load(arg1);
 			descrArg2->content.push_back(result);
-			result->variableDescriptor.clear();
-			result->variableDescriptor.emplace_back(descrArg2);
+			auto v = gen.state(result);
+			gen.variables.registers[v] = bit(descrArg2->reg);
+			gen.variables.inMemory[v] = false;
 		}
 
 		template<typename T>
@@ -595,8 +602,9 @@ namespace assembly
 		{
 			auto descr = gen.registerState.getEmptyRegister();
 			descr->content.push_back(result);
-			result->variableDescriptor.clear();
-			result->variableDescriptor.emplace_back(descr);
+			auto v = gen.state(result);
+			gen.variables.registers[v] = bit(descr->reg);
+			gen.variables.inMemory[v] = false;
 
 			if constexpr (std::same_as<T, bool>)
 			{
@@ -735,45 +743,64 @@ namespace assembly
 		}
 	}
 
-	void AsmGenerator::computeParameterOffsets(intermediate_rep::SymbolTable& para_scope)
+	void AsmGenerator::computeParameterOffsets(intermediate_rep::SymbolTable::Function& function)
 	{
 		int offset = -8;
-		for (auto& [name, entry] : para_scope.non_rec_view())
+		for (auto var : function.parameters)
 		{
-			auto& var = std::get<intermediate_rep::SymbolTable::Variable>(entry);
-			offset -= sizeOf.at(var.type);
-			var.basePointerOffset = offset;
-			var.variableDescriptor.push_back(intermediate_rep::SymbolTable::Variable::Memory{});
+			offset -= sizeOf.at(var->type);
+			variables.stackSlot[state(var)] = offset;
 		}
 	}
 
 	void AsmGenerator::computeLocalOffset(intermediate_rep::SymbolTable::Variable* var)
 	{
-		var->basePointerOffset = offset;
+		variables.stackSlot[state(var)] = offset;
 		offset += sizeOf.at(var->type);
 	}
 
-	void AsmGenerator::resetSymbolTable(intermediate_rep::SymbolTable& sym_table)
+	std::uint32_t AsmGenerator::state(intermediate_rep::SymbolTable::Variable* var)
 	{
-		for (auto& [name, entry] : sym_table)
+		auto v = var->index;
+		if (v >= variables.epoch.size())
+		{
+			variables.resize(v + 1);
+		}
+		if (variables.epoch[v] != epoch)
 		{
-			if (auto varPtr = std::get_if<intermediate_rep::SymbolTable::Variable>(&entry))
+			variables.epoch[v] = epoch;
+			variables.registers[v] = 0;
+			if (var->isTemp)
 			{
-				if (varPtr->name.starts_with("__"))
-				{
-					varPtr->live = false;
-					varPtr->nextUse = -1;
-					varPtr->variableDescriptor.clear();
-				}
-				else
-				{
-					varPtr->live = true;
-					varPtr->nextUse = 1000;
-					varPtr->variableDescriptor.clear();
-					varPtr->variableDescriptor.emplace_back(intermediate_rep::SymbolTable::Variable::Memory{});
-				}
+				// Temporaries only live inside their block
+				variables.live[v] = false;
+				variables.nextUse[v] = -1;
+				variables.inMemory[v] = false;
+			}
+			else
+			{
+				// Named variables come from and go back to memory
+				variables.live[v] = true;
+				variables.nextUse[v] = 1000;
+				variables.inMemory[v] = true;
 			}
 		}
+		return v;
+	}
+
+	void VariableStates::resize(std::size_t size)
+	{
+		registers.resize(size);
+		inMemory.resize(size);
+		live.resize(size);
+		nextUse.resize(size, -1);
+		stackSlot.resize(size);
+		epoch.resize(size);
+	}
+
+	void VariableStates::clear()
+	{
+		resize(0);
 	}
 
 	struct Visitor
@@ -66,7 +66,7 @@ namespace assembly
 
 			for (auto varPtr : descr.content)
 			{
-				os << varPtr->name << ", ";
+				os << intermediate_rep::tac::nameOf(*varPtr) << ", ";
 			}
 			os << "), ";
 		}
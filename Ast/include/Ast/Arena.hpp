@@ -0,0 +1,94 @@
+#ifndef arena_hpp
+#define arena_hpp
+#include <memory>
+#include <vector>
+#include <span>
+#include <string_view>
+#include <algorithm>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <iterator>
+
+namespace intermediate_rep
+{
+	// Bump pointer allocator, everything is released at once when the arena goes away.
+	// Destructors never run, so only trivially destructible objects can be created in it.
+	// Memory comes in blocks that never move, pointers stay valid when the arena is moved.
+	class Arena
+	{
+	public:
+		Arena() = default;
+
+		Arena(const Arena&) = delete;
+		Arena& operator=(const Arena&) = delete;
+
+		Arena(Arena&&) = default;
+		Arena& operator=(Arena&&) = default;
+
+		template<typename T, typename ... TArgs>
+		T* make(TArgs&& ... args)
+		{
+			static_assert(std::is_trivially_destructible_v<T>, "Arena objects are never destroyed");
+			return new (allocate(sizeof(T), alignof(T))) T(std::forward<TArgs>(args)...);
+		}
+
+		template<typename T>
+		std::span<T> copy(std::span<const T> values)
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "Arena arrays are copied bytewise");
+			if(values.empty())
+			{
+				return {};
+			}
+			auto data = static_cast<T*>(allocate(values.size_bytes(), alignof(T)));
+			std::copy(values.begin(), values.end(), data);
+			return {data, values.size()};
+		}
+
+		std::string_view copy(std::string_view text)
+		{
+			auto data = static_cast<char*>(allocate(text.size(), 1));
+			std::copy(text.begin(), text.end(), data);
+			return {data, text.size()};
+		}
+
+		void* allocate(std::size_t size, std::size_t alignment)
+		{
+			auto address = (reinterpret_cast<std::uintptr_t>(cursor) + alignment - 1) & ~(alignment - 1);
+			if(cursor == nullptr || address + size > reinterpret_cast<std::uintptr_t>(limit))
+			{
+				return grow(size, alignment);
+			}
+			cursor = reinterpret_cast<char*>(address + size);
+			return reinterpret_cast<void*>(address);
+		}
+
+		// Takes over the blocks of other, pointers into them stay valid
+		void adopt(Arena&& other)
+		{
+			blocks.insert(blocks.end(), std::make_move_iterator(other.blocks.begin()), std::make_move_iterator(other.blocks.end()));
+			reservedBytes += other.reservedBytes;
+			other = Arena{};
+		}
+
+		// Memory taken from the system, including unused space at the end of the blocks
+		std::size_t reserved() const
+		{
+			return reservedBytes;
+		}
+
+	private:
+		void* grow(std::size_t size, std::size_t alignment);
+
+		char* cursor = nullptr;
+		char* limit = nullptr;
+		std::size_t nextBlockSize = 16 * 1024;
+		std::size_t reservedBytes = 0;
+		std::vector<std::unique_ptr<char[]>> blocks;
+	};
+}
+
+#endif
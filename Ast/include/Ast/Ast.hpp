@@ -7,8 +7,12 @@
 #include <ostream>
 #include <string_view>
 #include "SymbolTable.hpp"
+#include "Arena.hpp"
+#include <span>
 #include <concepts>
 #include <stdexcept>
+#include <cstdint>
+#include <utility>
 
 namespace intermediate_rep::ast
 {
@@ -44,73 +48,60 @@ namespace intermediate_rep::ast
 
 	std::string_view unOpToStr(UnaryOperator op);
 
-	template<typename T, typename ... TArgs>
-	struct ExprVisitor;
+	enum class ExprKind : std::uint8_t
+	{
+		Binary,
+		Unary,
+		Variable,
+		Call,
+		IntConst,
+		FloatConst,
+		BoolConst,
+		StrConst,
+	};
 
+	// Nodes live in the Arena of their Program and are never destroyed one by one,
+	// children are plain pointers and spans into the same arena.
+	// The node set is closed: accept switches over kind and calls visitor.visit(node, args...)
+	// with the concrete node, so visitors pick their own argument and return types.
 	struct Expression
 	{
+		ExprKind kind;
 		SymbolTable::Variable::Type type;
-		Expression(SymbolTable::Variable::Type type);
-		virtual void accept(ExprVisitor<void>&) = 0;
-		virtual std::string accept(ExprVisitor<std::string,std::string>&, std::string) = 0;
-		virtual ~Expression(){}
+		Expression(ExprKind kind, SymbolTable::Variable::Type type);
+
+		template<typename Visitor, typename ... TArgs>
+		decltype(auto) accept(Visitor& visitor, TArgs&& ... args);
 	};
 
 	struct BinaryExpression : Expression
 	{
-		std::unique_ptr<Expression> left,right;
+		Expression* left,* right;
 		BinaryOperator op;
 
-		BinaryExpression(std::unique_ptr<Expression> left, std::unique_ptr<Expression> right, BinaryOperator op);
-
-		void accept(ExprVisitor<void>&) override;
-		std::string accept(ExprVisitor<std::string,std::string>&, std::string) override;
+		BinaryExpression(Expression* left, Expression* right, BinaryOperator op);
 	};
 
 	struct UnaryExpression : Expression
 	{
-		std::unique_ptr<Expression> expr;
+		Expression* expr;
 		UnaryOperator op;
-		UnaryExpression(std::unique_ptr<Expression> expr, UnaryOperator op);
-		void accept(ExprVisitor<void>&) override;
-		std::string accept(ExprVisitor<std::string,std::string>&, std::string) override;
+		UnaryExpression(Expression* expr, UnaryOperator op);
 	};
 
 	struct Variable : Expression
 	{
 		SymbolTable::Variable* sym_entry;
 		Variable(SymbolTable::Variable* sym_entry);
-		void accept(ExprVisitor<void>&) override;
-		std::string accept(ExprVisitor<std::string,std::string>&, std::string) override;
 	};
 
 	struct Call : Expression
 	{
 		SymbolTable::Function* sym_entry;
-		std::vector<std::unique_ptr<Expression>> args;
-		Call(SymbolTable::Function* sym_entry, std::vector<std::unique_ptr<Expression>> args);
-		void accept(ExprVisitor<void>&) override;
-		std::string accept(ExprVisitor<std::string,std::string>&, std::string) override;
+		std::span<Expression*> args;
+		Call(SymbolTable::Function* sym_entry, std::span<Expression*> args);
 	};
 
-	template<typename T>
-	struct Constant;
-
-	template<typename T, typename ... TArgs>
-	struct ExprVisitor
-	{
-		virtual T visit(BinaryExpression&, TArgs ...) = 0;
-		virtual T visit(UnaryExpression&, TArgs ...) = 0;
-		virtual T visit(Variable&,TArgs ...) = 0;
-		virtual T visit(Constant<int>&,TArgs ...) = 0;
-		virtual T visit(Constant<double>&,TArgs ...) = 0;
-		virtual T visit(Constant<bool>&,TArgs ...) = 0;
-		virtual T visit(Constant<std::string>&,TArgs ...) = 0;
-		virtual T visit(Call&, TArgs ...) = 0;
-
-		virtual ~ExprVisitor(){}
-	};
-		
 	template<typename T>
 	struct Constant : Expression
 	{
@@ -118,6 +109,27 @@ namespace intermediate_rep::ast
 
 		Constant(T value):
 			Expression([](){
+				if constexpr(std::same_as<int, T>)
+				{
+					return ExprKind::IntConst;
+				}
+				else if constexpr(std::same_as<double,T>)
+				{
+					return ExprKind::FloatConst;
+				}
+				else if constexpr(std::same_as<bool,T>)
+				{
+					return ExprKind::BoolConst;
+				}
+				else if constexpr(std::same_as<std::string_view,T>)
+				{
+					return ExprKind::StrConst;
+				}
+				else
+				{
+					throw std::runtime_error("Unkown Constant Type");
+				}
+			}(), [](){
 				if constexpr(std::same_as<int, T>)
 				{
 					return SymbolTable::Variable::Type::Int;
@@ -130,7 +142,7 @@ namespace intermediate_rep::ast
 				{
 					return SymbolTable::Variable::Type::Bool;
 				}
-				else if constexpr(std::same_as<std::string,T>)
+				else if constexpr(std::same_as<std::string_view,T>)
 				{
 					return SymbolTable::Variable::Type::Str;
 				}
@@ -141,91 +153,117 @@ namespace intermediate_rep::ast
 								
 			}()), value{std::move(value)}
 		{}
- 
-		void accept(ExprVisitor<void>& v) override
-		{
-			v.visit(*this);
-		}
-		std::string accept(ExprVisitor<std::string,std::string>& v, std::string arg) override
+	};
+
+	template<typename Visitor, typename ... TArgs>
+	decltype(auto) Expression::accept(Visitor& visitor, TArgs&& ... args)
+	{
+		switch(kind)
 		{
-			return v.visit(*this, arg);
+			case ExprKind::Binary:
+				return visitor.visit(static_cast<BinaryExpression&>(*this), std::forward<TArgs>(args)...);
+			case ExprKind::Unary:
+				return visitor.visit(static_cast<UnaryExpression&>(*this), std::forward<TArgs>(args)...);
+			case ExprKind::Variable:
+				return visitor.visit(static_cast<Variable&>(*this), std::forward<TArgs>(args)...);
+			case ExprKind::Call:
+				return visitor.visit(static_cast<Call&>(*this), std::forward<TArgs>(args)...);
+			case ExprKind::IntConst:
+				return visitor.visit(static_cast<Constant<int>&>(*this), std::forward<TArgs>(args)...);
+			case ExprKind::FloatConst:
+				return visitor.visit(static_cast<Constant<double>&>(*this), std::forward<TArgs>(args)...);
+			case ExprKind::BoolConst:
+				return visitor.visit(static_cast<Constant<bool>&>(*this), std::forward<TArgs>(args)...);
+			case ExprKind::StrConst:
+				return visitor.visit(static_cast<Constant<std::string_view>&>(*this), std::forward<TArgs>(args)...);
 		}
+		throw std::runtime_error("Unknown Expression Kind");
+	}
 
+	enum class StmtKind : std::uint8_t
+	{
+		ExprStmt,
+		If,
+		While,
+		Return,
+		Block,
 	};
 
-	template<typename T, typename ... TArgs>
-	struct StmtVisitor;
-
 	struct Statement
 	{
-		virtual void accept(StmtVisitor<void>&) = 0;
-		virtual std::string accept(StmtVisitor<std::string, std::string>&, std::string) = 0;
-		virtual ~Statement(){}
+		StmtKind kind;
+		Statement(StmtKind kind);
+
+		template<typename Visitor, typename ... TArgs>
+		decltype(auto) accept(Visitor& visitor, TArgs&& ... args);
 	};
 
 	struct ExprStmt : Statement
 	{
-		std::unique_ptr<Expression> expr;
-		ExprStmt(std::unique_ptr<Expression> expr);
-		void accept(StmtVisitor<void>&) override;
-		std::string accept(StmtVisitor<std::string, std::string>&, std::string) override;
+		Expression* expr;
+		ExprStmt(Expression* expr);
 	};
 
 	struct IfStmt : Statement
 	{
-		std::unique_ptr<Expression> condition;
-		std::unique_ptr<Statement> trueStmt;
-		std::unique_ptr<Statement> falseStmt;
-		IfStmt(std::unique_ptr<Expression> condition,std::unique_ptr<Statement> trueStmt,std::unique_ptr<Statement> falseStmt = nullptr);
-		void accept(StmtVisitor<void>&) override;
-		std::string accept(StmtVisitor<std::string, std::string>&, std::string) override;
+		Expression* condition;
+		Statement* trueStmt;
+		Statement* falseStmt;
+		IfStmt(Expression* condition, Statement* trueStmt, Statement* falseStmt = nullptr);
 	};
 
 	struct WhileStmt : Statement
 	{
-		std::unique_ptr<Expression> condition;
-		std::unique_ptr<Statement> stmt;
-		WhileStmt(std::unique_ptr<Expression> condition, std::unique_ptr<Statement> stmt);
-		void accept(StmtVisitor<void>&) override;
-		std::string accept(StmtVisitor<std::string, std::string>&, std::string) override;
+		Expression* condition;
+		Statement* stmt;
+		WhileStmt(Expression* condition, Statement* stmt);
 	};
 
 	struct ReturnStmt : Statement
 	{
-		std::unique_ptr<Expression> expr;
-		ReturnStmt(std::unique_ptr<Expression> expr = nullptr);
-		void accept(StmtVisitor<void>&) override;
-		std::string accept(StmtVisitor<std::string, std::string>&, std::string) override;
+		Expression* expr;
+		ReturnStmt(Expression* expr = nullptr);
 	};
 
 	struct Block : Statement
 	{
-		std::vector<std::unique_ptr<Statement>> stmts;
-		void accept(StmtVisitor<void>&) override;
-		std::string accept(StmtVisitor<std::string, std::string>&, std::string) override;
+		std::span<Statement*> stmts;
+		Block(std::span<Statement*> stmts = {});
 	};
 
-	template<typename T, typename ... TArgs>
-	struct StmtVisitor
+	template<typename Visitor, typename ... TArgs>
+	decltype(auto) Statement::accept(Visitor& visitor, TArgs&& ... args)
 	{
-		virtual T visit(ExprStmt&, TArgs ...) = 0;
-		virtual T visit(IfStmt&, TArgs ...) = 0;
-		virtual T visit(WhileStmt&, TArgs ...) = 0;
-		virtual T visit(ReturnStmt&, TArgs ...) = 0;
-		virtual T visit(Block&, TArgs ...) = 0;
-		virtual ~StmtVisitor(){} 
-	};
+		switch(kind)
+		{
+			case StmtKind::ExprStmt:
+				return visitor.visit(static_cast<ExprStmt&>(*this), std::forward<TArgs>(args)...);
+			case StmtKind::If:
+				return visitor.visit(static_cast<IfStmt&>(*this), std::forward<TArgs>(args)...);
+			case StmtKind::While:
+				return visitor.visit(static_cast<WhileStmt&>(*this), std::forward<TArgs>(args)...);
+			case StmtKind::Return:
+				return visitor.visit(static_cast<ReturnStmt&>(*this), std::forward<TArgs>(args)...);
+			case StmtKind::Block:
+				return visitor.visit(static_cast<Block&>(*this), std::forward<TArgs>(args)...);
+		}
+		throw std::runtime_error("Unknown Statement Kind");
+	}
 
 	struct Function
 	{
 		SymbolTable::Function* sym_entry;
-		std::unique_ptr<Block> block;
+		Block* block;
 	};
 	
 	struct Program
 	{
 		std::unique_ptr<SymbolTable> root;
 		std::vector<Function> functions;
+		// Names of all symbols, owned by the compilation
+		Interner* names;
+		// Holds all nodes, the tree is freed with it
+		Arena arena;
 	};
 
 
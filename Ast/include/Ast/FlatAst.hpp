@@ -0,0 +1,86 @@
+#ifndef flatast_hpp
+#define flatast_hpp
+#include "Ast.hpp"
+#include <vector>
+#include <span>
+#include <string_view>
+#include <cstdint>
+#include <limits>
+
+namespace intermediate_rep::ast
+{
+	// Data oriented copy of a Program: all nodes of all functions in one array,
+	// children referenced by 32 bit index. Children are stored before their parent,
+	// so a walk over a function touches memory mostly front to back.
+	// Traversal is a switch over Node::kind, there are no virtual calls.
+
+	using NodeId = std::uint32_t;
+
+	inline constexpr NodeId noNode = std::numeric_limits<NodeId>::max();
+
+	enum class NodeKind : std::uint8_t
+	{
+		// Expressions
+		Binary,		// a = left, b = right, op = BinaryOperator
+		Unary,		// a = operand, op = UnaryOperator
+		Variable,	// a = index into FlatAst::variables
+		Call,		// a = index into FlatAst::functions, b = first argument in FlatAst::lists, c = argument count
+		IntConst,	// a = value
+		FloatConst,	// a = index into FlatAst::floats
+		BoolConst,	// a = value
+		StrConst,	// a = index into FlatAst::strings
+
+		// Statements
+		ExprStmt,	// a = expression
+		If,			// a = condition, b = true statement, c = false statement or noNode
+		While,		// a = condition, b = statement
+		Return,		// a = expression or noNode
+		Block,		// b = first statement in FlatAst::lists, c = statement count
+	};
+
+	struct Node
+	{
+		NodeKind kind;
+		std::uint8_t op = 0;
+		SymbolTable::Variable::Type type = SymbolTable::Variable::Type::Int;	// of expressions
+		NodeId a = noNode;
+		NodeId b = noNode;
+		NodeId c = noNode;
+	};
+
+	static_assert(sizeof(Node) == 16, "Nodes are meant to stay small");
+
+	struct FlatFunction
+	{
+		SymbolTable::Function* sym_entry;
+		NodeId body;	// Block
+	};
+
+	struct FlatAst
+	{
+		std::vector<Node> nodes;
+		std::vector<NodeId> lists;	// children of Block and Call
+		std::vector<SymbolTable::Variable*> variables;
+		std::vector<SymbolTable::Function*> functions;
+		std::vector<double> floats;
+		std::vector<std::string_view> strings;	// point into the Program's arena
+		std::vector<FlatFunction> bodies;
+		Interner* names = nullptr;
+
+		const Node& operator[](NodeId id) const
+		{
+			return nodes[id];
+		}
+
+		// Statements of a Block or arguments of a Call
+		std::span<const NodeId> children(const Node& node) const
+		{
+			return std::span<const NodeId>{lists}.subspan(node.b, node.c);
+		}
+	};
+
+	// The flat copy refers to the symbol tables and strings of program, which has to outlive it
+	FlatAst flatten(Program& program);
+}
+
+#endif
@@ -2,18 +2,18 @@
 #define symboltable_hpp
 #include <memory>
 #include <vector>
-#include <map>
+#include <ranges>
+#include <utility>
+#include <cstdint>
+#include <bit>
 #include <string>
+#include <string_view>
 #include <stack>
 #include <variant>
 #include <concepts>
 #include <stdexcept>
 #include <stack>
-
-namespace assembly
-{
-	struct RegisterDescriptor;
-}
+#include "Token/Interner.hpp"
 
 namespace intermediate_rep
 {
@@ -21,24 +21,26 @@ namespace intermediate_rep
 	// Store Information about Identifiers
 
 	// Variables:
-	// where they are located in Memory or in which register they reside
+	// the type, and an index for the tables of later stages
 	// Function:
 	// the retrurn type, parameters
 
-	class RecursiveSymTableIterator;
-
-
 	class SymbolTable
 	{
 	public:
 		
 		SymbolTable(SymbolTable* parent = nullptr);
 
-		// All Compiler generated Variables start with two underscores (__)
+		// Frees the scopes below with a loop, scopes can nest arbitrarily deep
+		~SymbolTable();
+
+		// Temporaries of the TAC are Variables too, but are owned by their tac::Function
+		// and never entered into a SymbolTable
 		struct Variable
 		{
-			std::string name;
-			enum Type
+			SymbolId id;			// the number of the temporary for temporaries
+			std::string_view name;	// owned by the Interner, empty for temporaries
+			enum Type : std::uint8_t
 			{
 				Int,	// 8 Byte
 				Float,	// 8 Byte
@@ -46,53 +48,52 @@ namespace intermediate_rep
 				Bool	// 1 Byte
 			} type;
 
-			// -1 means no next use
-			
-			
-			int nextUse = -1;
-
-			bool live = false;
-
+			// Dense index among the variables of its function, see tac::numberVariables.
+			// Code generation keeps its per variable state in tables indexed by it.
+			std::uint32_t index = 0;
 
-			struct Memory
-			{};
-
-			int basePointerOffset = 0;
-
-			// indicates where the most recent version of the variable lies
-			std::vector<std::variant<assembly::RegisterDescriptor*, Memory>> variableDescriptor;
+			bool isTemp = false;
 		};
 
 		struct Function
 		{
-			std::string name;
+			SymbolId id;
+			std::string_view name;	// owned by the Interner
 			Variable::Type returnType;
 			SymbolTable* parameter_scope = nullptr;
-			std::vector<Variable*> parameters;
+			std::vector<Variable*> parameters = {};
 		};
 
 		using Symbol = std::variant<Variable, Function>;
+
+		using Entry = std::pair<const SymbolId, Symbol>;
  
-		Symbol& operator[](const std::string& key);
+		Symbol& operator[](SymbolId key);
+
+		// Symbol named key in this scope or an enclosing one, nullptr if there is none
+		Symbol* lookup(SymbolId key);
 
+		// Whether key is declared in this scope itself
+		bool declares(SymbolId key) const;
 
-		Symbol& insert(const std::string& key, Symbol v);
+
+		Symbol& insert(SymbolId key, Symbol v);
 
 		template<typename T>
 			requires std::same_as<T, SymbolTable::Variable> || std::same_as<T, SymbolTable::Function>
-		T & get(const std::string & key)
+		T & get(SymbolId key)
 		{
 			auto ptr = std::get_if<T>(&(*this)[key]);
 			if (ptr == nullptr)
 			{
-				throw std::runtime_error("");
+				throw std::runtime_error(std::same_as<T, SymbolTable::Variable> ? "Symbol is not a variable" : "Symbol is not a function");
 			}
 			return *ptr;
 		}
 
 		template<typename T>
 			requires std::same_as<T, SymbolTable::Variable> || std::same_as<T, SymbolTable::Function>
-		T & insert(const std::string & key, T v)
+		T & insert(SymbolId key, T v)
 		{
 			return std::get<T>(insert(key, Symbol{ std::move(v) }));
 		}
@@ -104,56 +105,44 @@ namespace intermediate_rep
 
 		SymbolTable& getChild(std::size_t indx);
 
-		friend class RecursiveSymTableIterator;
-
-		RecursiveSymTableIterator begin();
-		RecursiveSymTableIterator end();
-
+		// The symbols of this scope only, in order of insertion
 		auto non_rec_view()
 		{
-			class SymTableView
-			{
-			public:
-				SymTableView(SymbolTable& sym_table):
-					sym_table{ sym_table }
-				{}
-
-				auto begin()
-				{
-					return sym_table.table.begin();
-				}
-
-				auto end()
-				{
-					return sym_table.table.end();
-				}
-
-			private:
-				SymbolTable& sym_table;
-			};
-			return SymTableView{*this};
+			return chunks | std::views::join;
 		}
 
 	private:
-		std::map<std::string, Symbol> table;
-		SymbolTable* parent;
-		std::vector<std::unique_ptr<SymbolTable>> children;
-	};
+		// Index of the symbol named key, or emptySlot
+		std::uint32_t find(SymbolId key) const;
 
-	class RecursiveSymTableIterator
-	{
-	public:
-		RecursiveSymTableIterator() = default;
-		RecursiveSymTableIterator(SymbolTable* sym_table);
-		decltype(SymbolTable::table)::value_type& operator*();
-		RecursiveSymTableIterator& operator++();
-		RecursiveSymTableIterator operator++(int);
-		bool operator!=(const RecursiveSymTableIterator& other);
+		void grow();
 
-	private:
-		std::stack<SymbolTable*> stack;
-		decltype(SymbolTable::table)::iterator begin = {};
-		decltype(SymbolTable::table)::iterator end = {};
+		// Symbol at index in order of insertion
+		const Entry& entry(std::uint32_t index) const
+		{
+			// Chunk k starts at index (firstChunkSize << k) - firstChunkSize
+			auto shifted = index + firstChunkSize;
+			auto chunk = std::bit_width(shifted) - std::bit_width(firstChunkSize);
+			return chunks[chunk][shifted - (firstChunkSize << chunk)];
+		}
+
+		Entry& entry(std::uint32_t index)
+		{
+			return const_cast<Entry&>(std::as_const(*this).entry(index));
+		}
+
+		static constexpr std::uint32_t emptySlot = UINT32_MAX;
+		static constexpr std::uint32_t firstChunkSize = 8;
+
+		// Symbols in order of insertion. Chunk k has room for firstChunkSize << k of them and is
+		// never reallocated, so references to symbols stay valid while the scope grows.
+		std::vector<std::vector<Entry>> chunks;
+		std::uint32_t count = 0;
+		// Open addressing with linear probing over the interned names, slots hold symbol indices.
+		// The size is a power of two and at most half of the slots are used.
+		std::vector<std::uint32_t> slots;
+		SymbolTable* parent;
+		std::vector<std::unique_ptr<SymbolTable>> children;
 	};
 
 	// Class lets me build the symbol table incrementally
@@ -0,0 +1,29 @@
+#include "Arena.hpp"
+#include <stdexcept>
+
+namespace intermediate_rep
+{
+	namespace
+	{
+		// Blocks double up to this size, keeps the waste of the last block bounded
+		constexpr std::size_t maxBlockSize = 1024 * 1024;
+	}
+
+	void* Arena::grow(std::size_t size, std::size_t alignment)
+	{
+		if(alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+		{
+			throw std::runtime_error("Arena alignment not supported");
+		}
+
+		// Oversized requests get a block of their own
+		auto blockSize = std::max(nextBlockSize, size);
+		blocks.push_back(std::make_unique_for_overwrite<char[]>(blockSize));
+		reservedBytes += blockSize;
+		nextBlockSize = std::min(nextBlockSize * 2, maxBlockSize);
+
+		cursor = blocks.back().get() + size;
+		limit = blocks.back().get() + blockSize;
+		return blocks.back().get();
+	}
+}
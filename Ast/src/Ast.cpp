@@ -2,39 +2,23 @@
 #include <stdexcept>
 #include <iostream>
 #include <ios>
-
-#define ACCEPT(Class, Visitor) void Class::accept(Visitor<void> & v){v.visit(*this);}
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
 
 namespace intermediate_rep::ast
 {
-	ACCEPT(BinaryExpression, ExprVisitor)
-	ACCEPT(UnaryExpression, ExprVisitor)
-	ACCEPT(Variable, ExprVisitor)
-	ACCEPT(Call, ExprVisitor)
-
-	ACCEPT(ExprStmt, StmtVisitor)
-	ACCEPT(IfStmt, StmtVisitor)
-	ACCEPT(WhileStmt, StmtVisitor)
-	ACCEPT(ReturnStmt, StmtVisitor)
-	ACCEPT(Block, StmtVisitor)
-
-	std::string ExprStmt::accept(StmtVisitor<std::string,std::string> & v, std::string arg){return v.visit(*this,arg);}
-	std::string IfStmt::accept(StmtVisitor<std::string,std::string> & v, std::string arg){return v.visit(*this,arg);}
-	std::string WhileStmt::accept(StmtVisitor<std::string,std::string> & v, std::string arg){return v.visit(*this,arg);}
-	std::string ReturnStmt::accept(StmtVisitor<std::string,std::string> & v, std::string arg){return v.visit(*this,arg);}
-	std::string Block::accept(StmtVisitor<std::string,std::string> & v, std::string arg){return v.visit(*this,arg);}
-
-	std::string BinaryExpression::accept(ExprVisitor<std::string,std::string> & v, std::string arg){return v.visit(*this,arg);}
-	std::string UnaryExpression::accept(ExprVisitor<std::string,std::string> & v, std::string arg){return v.visit(*this,arg);}
-	std::string Variable::accept(ExprVisitor<std::string,std::string> & v, std::string arg){return v.visit(*this,arg);}
-	std::string Call::accept(ExprVisitor<std::string,std::string> & v, std::string arg){return v.visit(*this,arg);}
-
-	Expression::Expression(SymbolTable::Variable::Type type):
-		type{type}
+	Expression::Expression(ExprKind kind, SymbolTable::Variable::Type type):
+		kind{kind}, type{type}
+	{}
+
+	Statement::Statement(StmtKind kind):
+		kind{kind}
 	{}
 
-	BinaryExpression::BinaryExpression(std::unique_ptr<Expression> left, std::unique_ptr<Expression> right, BinaryOperator op):
-		Expression([op,&left](){
+	BinaryExpression::BinaryExpression(Expression* left, Expression* right, BinaryOperator op):
+		Expression(ExprKind::Binary, [op,&left](){
 			using enum intermediate_rep::ast::BinaryOperator;
 			switch(op)
 			{
@@ -57,38 +41,42 @@ namespace intermediate_rep::ast
 				throw std::runtime_error("Unkown Binary Operator Missing Case Stmt");
 			}
 
-		}()),left{std::move(left)}, right{std::move(right)}, op{op}
+		}()),left{left}, right{right}, op{op}
 	{}
 
-	UnaryExpression::UnaryExpression(std::unique_ptr<Expression> expr, UnaryOperator op):
-		Expression(expr->type),
-		expr{std::move(expr)}, op{op}
+	UnaryExpression::UnaryExpression(Expression* expr, UnaryOperator op):
+		Expression(ExprKind::Unary, expr->type),
+		expr{expr}, op{op}
 	{}
 
 	Variable::Variable(SymbolTable::Variable* sym_entry):
-		Expression(sym_entry->type),
+		Expression(ExprKind::Variable, sym_entry->type),
 		sym_entry{sym_entry}
 	{}
 
-	Call::Call(SymbolTable::Function* sym_entry, std::vector<std::unique_ptr<Expression>> args):
-		Expression(sym_entry->returnType),
-		sym_entry{sym_entry}, args{std::move(args)}
+	Call::Call(SymbolTable::Function* sym_entry, std::span<Expression*> args):
+		Expression(ExprKind::Call, sym_entry->returnType),
+		sym_entry{sym_entry}, args{args}
 	{}
 
-	WhileStmt::WhileStmt(std::unique_ptr<Expression> condition, std::unique_ptr<Statement> stmt):
-		condition{std::move(condition)}, stmt{std::move(stmt)}
+	WhileStmt::WhileStmt(Expression* condition, Statement* stmt):
+		Statement(StmtKind::While), condition{condition}, stmt{stmt}
 	{}
 
-	IfStmt::IfStmt(std::unique_ptr<Expression> condition,std::unique_ptr<Statement> trueStmt,std::unique_ptr<Statement> falseStmt):
-		condition{std::move(condition)}, trueStmt{std::move(trueStmt)}, falseStmt{std::move(falseStmt)}
+	IfStmt::IfStmt(Expression* condition, Statement* trueStmt, Statement* falseStmt):
+		Statement(StmtKind::If), condition{condition}, trueStmt{trueStmt}, falseStmt{falseStmt}
 	{}
 
-	ExprStmt::ExprStmt(std::unique_ptr<Expression> expr):
-		expr{std::move(expr)}
+	ExprStmt::ExprStmt(Expression* expr):
+		Statement(StmtKind::ExprStmt), expr{expr}
 		{}
 
-	ReturnStmt::ReturnStmt(std::unique_ptr<Expression> expr):
-		expr{std::move(expr)}
+	ReturnStmt::ReturnStmt(Expression* expr):
+		Statement(StmtKind::Return), expr{expr}
+	{}
+
+	Block::Block(std::span<Statement*> stmts):
+		Statement(StmtKind::Block), stmts{stmts}
 	{}
 
 	std::string_view binOpToStr(BinaryOperator op)
@@ -152,155 +140,157 @@ namespace intermediate_rep::ast
 	}
 
 
-	struct Visitor : ExprVisitor<void>, StmtVisitor<void>
+	// Prints with an explicit stack of pending nodes and lines instead of recursing,
+	// so deeply nested programs cost heap memory instead of native stack
+	struct Visitor
 	{
 		std::ostream& os;
-		int indentation_level;
 		int offset;
-		Visitor(std::ostream& os, int indentation_level = 0, int offset = 15):
-			os{os}, indentation_level{indentation_level}, offset{offset}
+
+		// A node to print at indent, or a line of text if there is no node
+		struct Task
+		{
+			Expression* expr = nullptr;
+			Statement* stmt = nullptr;
+			std::string_view text = {};
+			int indent = 0;
+		};
+		std::vector<Task> tasks;
+
+		Visitor(std::ostream& os, int offset = 15):
+			os{os}, offset{offset}
 		{}
 
 		void drawIndent(int n)
 		{
+			// Lines of deeply nested programs are long, write the runs at once
+			os << std::string(std::max(0, n - offset), ' ') << '|' << std::string(std::max(0, offset - 1), '_');
+		}
 
-			for(int i = 0; i < n - offset; ++i)
-			{
-				os << ' ';
-			}
-			os << "|";
-			for(int i = 1; i < offset; ++i)
+		void print(Statement* root, int indent)
+		{
+			tasks.push_back({nullptr, root, {}, indent});
+			while(!tasks.empty())
 			{
-				os << "_";
+				auto task = tasks.back();
+				tasks.pop_back();
+				if(task.expr)
+				{
+					task.expr->accept(*this, task.indent);
+				}
+				else if(task.stmt)
+				{
+					task.stmt->accept(*this, task.indent);
+				}
+				else
+				{
+					drawIndent(task.indent);
+					os << task.text << '\n';
+				}
 			}
-
 		}
 
-		void visit(ExprStmt& stmt) override
+		// The parts of a node are pushed last to first, so they are printed first to last
+
+		void visit(ExprStmt& stmt, int indent)
 		{
-			stmt.expr->accept(*this);
+			tasks.push_back({stmt.expr, nullptr, {}, indent});
 		}
 
-		void visit(IfStmt& stmt) override
+		void visit(IfStmt& stmt, int indent)
 		{
-			auto indent = indentation_level;
 			drawIndent(indent);
-			os << "If\n";	
-			indentation_level = indent + offset;
-			stmt.condition->accept(*this);
-			drawIndent(indent + offset);
-			os << "Then\n";
-			indentation_level = indent + 2 * offset;
-			stmt.trueStmt->accept(*this);
+			os << "If\n";
 			if(stmt.falseStmt)
 			{
-				drawIndent(indent + offset);
-				os << "Else\n";
-				indentation_level = indent + 2 * offset;
-				stmt.falseStmt->accept(*this);
+				tasks.push_back({nullptr, stmt.falseStmt, {}, indent + 2 * offset});
+				tasks.push_back({nullptr, nullptr, "Else", indent + offset});
 			}
-
+			tasks.push_back({nullptr, stmt.trueStmt, {}, indent + 2 * offset});
+			tasks.push_back({nullptr, nullptr, "Then", indent + offset});
+			tasks.push_back({stmt.condition, nullptr, {}, indent + offset});
 		}
-		void visit(WhileStmt& stmt) override
+
+		void visit(WhileStmt& stmt, int indent)
 		{
-			auto indent = indentation_level;
 			drawIndent(indent);
 			os << "While\n";
-			indentation_level = indent + offset;
-			stmt.condition->accept(*this);
-			drawIndent(indent);
-			os << "Then\n";
-			indentation_level = indent + offset;
-			stmt.stmt->accept(*this);
+			tasks.push_back({nullptr, stmt.stmt, {}, indent + offset});
+			tasks.push_back({nullptr, nullptr, "Then", indent});
+			tasks.push_back({stmt.condition, nullptr, {}, indent + offset});
 		}
 
-		void visit(Block& block) override
+		void visit(Block& block, int indent)
 		{
-			auto indent = indentation_level;
-			for(auto& stmt : block.stmts)
+			for(auto iter = block.stmts.rbegin(); iter != block.stmts.rend(); ++iter)
 			{
-				stmt->accept(*this);
-				indentation_level = indent;
+				tasks.push_back({nullptr, *iter, {}, indent});
 			}
 		}
 
-		void visit(ReturnStmt& stmt) override
+		void visit(ReturnStmt& stmt, int indent)
 		{
-			auto indent = indentation_level;
 			drawIndent(indent);
 			os << "Return\n";
 			if(stmt.expr)
 			{
-				indentation_level = indent + 15;
-				stmt.expr->accept(*this);
+				tasks.push_back({stmt.expr, nullptr, {}, indent + 15});
 			}
 
 		}
 
-		void visit(BinaryExpression& expr) override
+		void visit(BinaryExpression& expr, int indent)
 		{
-			auto indent = indentation_level;
 			drawIndent(indent);
 			os << binOpToStr(expr.op) << '\n';
-			indentation_level = indent + offset;
-			expr.left->accept(*this);
-			indentation_level = indent + offset;
-			expr.right->accept(*this);
+			tasks.push_back({expr.right, nullptr, {}, indent + offset});
+			tasks.push_back({expr.left, nullptr, {}, indent + offset});
 		}
 
-		void visit(UnaryExpression& expr) override
+		void visit(UnaryExpression& expr, int indent)
 		{
-			auto indent = indentation_level;
 			drawIndent(indent);
 			os << unOpToStr(expr.op) << '\n';
-			indentation_level = indent + offset;
-			expr.expr->accept(*this);
+			tasks.push_back({expr.expr, nullptr, {}, indent + offset});
 		}
 
-		void visit(Variable& v) override
+		void visit(Variable& v, int indent)
 		{
-			auto indent = indentation_level;
 			drawIndent(indent);
 			os << v.sym_entry->name << '\n';
 		}
 
-		void visit(Call& call) override
+		void visit(Call& call, int indent)
 		{
-			auto indent = indentation_level;
 			drawIndent(indent);
 			os << "Call " <<call.sym_entry->name << '\n';
-			for(auto& expr : call.args)
+			for(auto iter = call.args.rbegin(); iter != call.args.rend(); ++iter)
 			{
-				indentation_level = indent + offset;
-				expr->accept(*this);
+				tasks.push_back({*iter, nullptr, {}, indent + offset});
 			}
 		}
 
-		void visit(Constant<int>& c) override
+		void visit(Constant<int>& c, int indent)
 		{
-			auto indent = indentation_level;
 			drawIndent(indent);
 			os << c.value << '\n';
 		}
 
-		void visit(Constant<double>& c) override
+		void visit(Constant<double>& c, int indent)
 		{
-			auto indent = indentation_level;
 			drawIndent(indent);
 			os << c.value << '\n';
 		}
 
-		void visit(Constant<bool>& c) override
+		void visit(Constant<bool>& c, int indent)
 		{
 			std::cout << std::boolalpha;
-			auto indent = indentation_level;
 			drawIndent(indent);
 			os << c.value << '\n';
 		}
 
-		void visit(Constant<std::string>& c) override
+		void visit(Constant<std::string_view>& c, int indent)
 		{
-			auto indent = indentation_level;
 			drawIndent(indent);
 			os << c.value << '\n';
 		}
@@ -308,12 +298,11 @@ namespace intermediate_rep::ast
 
 	std::ostream& operator<<(std::ostream& os, const Program& program)
 	{
-		Visitor visitor{os, 15};
+		Visitor visitor{os};
 		for(auto& function : program.functions)
 		{
 			os << "Function " << function << '\n';
-			function.block->accept(visitor);
-			visitor.indentation_level = 15;
+			visitor.print(function.block, 15);
 		}
 		return os;
 	}
@@ -325,5 +314,3 @@ namespace intermediate_rep::ast
 		return os;
 	}
 }
-
-#undef ACCEPT
\ No newline at end of file
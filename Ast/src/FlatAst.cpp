@@ -0,0 +1,262 @@
+#include "FlatAst.hpp"
+#include <algorithm>
+#include <array>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+
+namespace intermediate_rep::ast
+{
+	namespace
+	{
+		// Appends the children first, then the node itself. Walks with an explicit stack,
+		// so deeply nested programs cost heap memory instead of native stack.
+		struct Flattener
+		{
+			FlatAst& flat;
+
+			// A node to flatten, ready once its children were pushed in front of it
+			struct Task
+			{
+				Expression* expr = nullptr;
+				Statement* stmt = nullptr;
+				bool ready = false;
+			};
+			std::vector<Task> tasks;
+			// Ids of the flattened children not yet taken by their parent
+			std::vector<NodeId> results;
+
+			Flattener(FlatAst& flat):
+				flat{flat}
+			{}
+
+			NodeId add(Node node)
+			{
+				flat.nodes.push_back(node);
+				return static_cast<NodeId>(flat.nodes.size() - 1);
+			}
+
+			// Flattens the children left to right: pushed last, taken first
+			void push(std::initializer_list<Expression*> exprs, std::initializer_list<Statement*> stmts = {})
+			{
+				for(auto iter = std::rbegin(stmts); iter != std::rend(stmts); ++iter)
+				{
+					tasks.push_back({nullptr, *iter});
+				}
+				for(auto iter = std::rbegin(exprs); iter != std::rend(exprs); ++iter)
+				{
+					tasks.push_back({*iter});
+				}
+			}
+
+			// Takes the ids of the last count children, in order
+			std::array<NodeId, 3> take(std::size_t count)
+			{
+				std::array<NodeId, 3> children{noNode, noNode, noNode};
+				std::copy(results.end() - count, results.end(), children.begin());
+				results.resize(results.size() - count);
+				return children;
+			}
+
+			// Moves the ids of the last count children into lists, returns the index of the first one
+			NodeId list(std::size_t count)
+			{
+				auto begin = static_cast<NodeId>(flat.lists.size());
+				flat.lists.insert(flat.lists.end(), results.end() - count, results.end());
+				results.resize(results.size() - count);
+				return begin;
+			}
+
+			NodeId run(Statement* root)
+			{
+				tasks.push_back({nullptr, root});
+				while(!tasks.empty())
+				{
+					auto task = tasks.back();
+					tasks.pop_back();
+					if(task.expr == nullptr && task.stmt == nullptr)
+					{
+						results.push_back(noNode);
+					}
+					else if(!task.ready)
+					{
+						task.ready = true;
+						tasks.push_back(task);
+						if(task.expr != nullptr)
+						{
+							task.expr->accept(*this, std::false_type{});
+						}
+						else
+						{
+							task.stmt->accept(*this, std::false_type{});
+						}
+					}
+					else
+					{
+						results.push_back(task.expr != nullptr ? task.expr->accept(*this, std::true_type{}) : task.stmt->accept(*this, std::true_type{}));
+					}
+				}
+				return take(1)[0];
+			}
+
+			// visit(node, std::false_type) pushes the children of node,
+			// visit(node, std::true_type) adds node once they are flattened
+
+			NodeId visit(BinaryExpression& e, std::false_type)
+			{
+				push({e.left, e.right});
+				return noNode;
+			}
+
+			NodeId visit(BinaryExpression& e, std::true_type)
+			{
+				auto children = take(2);
+				return add({NodeKind::Binary, static_cast<std::uint8_t>(e.op), e.type, children[0], children[1]});
+			}
+
+			NodeId visit(UnaryExpression& e, std::false_type)
+			{
+				push({e.expr});
+				return noNode;
+			}
+
+			NodeId visit(UnaryExpression& e, std::true_type)
+			{
+				auto operand = take(1)[0];
+				return add({NodeKind::Unary, static_cast<std::uint8_t>(e.op), e.type, operand});
+			}
+
+			NodeId visit(Variable&, std::false_type)
+			{
+				return noNode;
+			}
+
+			NodeId visit(Variable& e, std::true_type)
+			{
+				flat.variables.push_back(e.sym_entry);
+				return add({NodeKind::Variable, 0, e.type, static_cast<NodeId>(flat.variables.size() - 1)});
+			}
+
+			NodeId visit(Call& e, std::false_type)
+			{
+				for(auto iter = e.args.rbegin(); iter != e.args.rend(); ++iter)
+				{
+					tasks.push_back({*iter});
+				}
+				return noNode;
+			}
+
+			NodeId visit(Call& e, std::true_type)
+			{
+				auto count = static_cast<NodeId>(e.args.size());
+				auto begin = list(count);
+				flat.functions.push_back(e.sym_entry);
+				return add({NodeKind::Call, 0, e.type, static_cast<NodeId>(flat.functions.size() - 1), begin, count});
+			}
+
+			template<typename T>
+			NodeId visit(Constant<T>&, std::false_type)
+			{
+				return noNode;
+			}
+
+			NodeId visit(Constant<int>& e, std::true_type)
+			{
+				return add({NodeKind::IntConst, 0, e.type, static_cast<NodeId>(e.value)});
+			}
+
+			NodeId visit(Constant<double>& e, std::true_type)
+			{
+				flat.floats.push_back(e.value);
+				return add({NodeKind::FloatConst, 0, e.type, static_cast<NodeId>(flat.floats.size() - 1)});
+			}
+
+			NodeId visit(Constant<bool>& e, std::true_type)
+			{
+				return add({NodeKind::BoolConst, 0, e.type, e.value ? 1u : 0u});
+			}
+
+			NodeId visit(Constant<std::string_view>& e, std::true_type)
+			{
+				flat.strings.push_back(e.value);
+				return add({NodeKind::StrConst, 0, e.type, static_cast<NodeId>(flat.strings.size() - 1)});
+			}
+
+			NodeId visit(ExprStmt& s, std::false_type)
+			{
+				push({s.expr});
+				return noNode;
+			}
+
+			NodeId visit(ExprStmt&, std::true_type)
+			{
+				auto e = take(1)[0];
+				return add({NodeKind::ExprStmt, 0, {}, e});
+			}
+
+			NodeId visit(IfStmt& s, std::false_type)
+			{
+				push({s.condition}, {s.trueStmt, s.falseStmt});
+				return noNode;
+			}
+
+			NodeId visit(IfStmt&, std::true_type)
+			{
+				auto children = take(3);
+				return add({NodeKind::If, 0, {}, children[0], children[1], children[2]});
+			}
+
+			NodeId visit(WhileStmt& s, std::false_type)
+			{
+				push({s.condition}, {s.stmt});
+				return noNode;
+			}
+
+			NodeId visit(WhileStmt&, std::true_type)
+			{
+				auto children = take(2);
+				return add({NodeKind::While, 0, {}, children[0], children[1]});
+			}
+
+			NodeId visit(ReturnStmt& s, std::false_type)
+			{
+				push({s.expr});
+				return noNode;
+			}
+
+			NodeId visit(ReturnStmt&, std::true_type)
+			{
+				auto e = take(1)[0];
+				return add({NodeKind::Return, 0, {}, e});
+			}
+
+			NodeId visit(Block& s, std::false_type)
+			{
+				for(auto iter = s.stmts.rbegin(); iter != s.stmts.rend(); ++iter)
+				{
+					tasks.push_back({nullptr, *iter});
+				}
+				return noNode;
+			}
+
+			NodeId visit(Block& s, std::true_type)
+			{
+				auto count = static_cast<NodeId>(s.stmts.size());
+				auto begin = list(count);
+				return add({NodeKind::Block, 0, {}, noNode, begin, count});
+			}
+		};
+	}
+
+	FlatAst flatten(Program& program)
+	{
+		FlatAst flat;
+		flat.names = program.names;
+		Flattener flattener{flat};
+		for(auto& function : program.functions)
+		{
+			flat.bodies.push_back({function.sym_entry, flattener.run(function.block)});
+		}
+		return flat;
+	}
+}
@@ -1,6 +1,9 @@
 #include "SymbolTable.hpp"
 #include <stdexcept>
 #include <iostream>
+#include <algorithm>
+#include <iterator>
+#include <utility>
 
 namespace intermediate_rep
 {
@@ -9,54 +12,129 @@ namespace intermediate_rep
 	{
 	}
 
-	SymbolTable::Symbol& SymbolTable::operator[](const std::string& key)
+	SymbolTable::~SymbolTable()
 	{
-		if(table.contains(key))
+		// Every scope gives up its children before it is freed, so no destructor recurses
+		auto scopes = std::move(children);
+		while(!scopes.empty())
 		{
-			return table[key];
+			auto scope = std::move(scopes.back());
+			scopes.pop_back();
+			std::move(scope->children.begin(), scope->children.end(), std::back_inserter(scopes));
+			scope->children.clear();
 		}
-		else if(parent != nullptr)
+	}
+
+	namespace
+	{
+		// Ids are dense, spread them over the slots
+		std::size_t slotOf(SymbolId key, std::size_t mask)
 		{
-			return (*parent)[key];
+			std::uint32_t hash = key * 0x9E3779B1u;
+			return (hash ^ (hash >> 15)) & mask;
 		}
-		else
+	}
+
+	std::uint32_t SymbolTable::find(SymbolId key) const
+	{
+		if(slots.empty())
+		{
+			return emptySlot;
+		}
+		auto mask = slots.size() - 1;
+		for(auto slot = slotOf(key, mask);; slot = (slot + 1) & mask)
 		{
-			throw std::runtime_error("Symbol not found");
+			auto index = slots[slot];
+			if(index == emptySlot || entry(index).first == key)
+			{
+				return index;
+			}
 		}
 	}
 
-	SymbolTable::Symbol& SymbolTable::insert(const std::string& key, SymbolTable::Symbol v)
+	void SymbolTable::grow()
 	{
-		if(table.contains(key))
+		slots.assign(std::max<std::size_t>(8, slots.size() * 2), emptySlot);
+		auto mask = slots.size() - 1;
+		for(std::uint32_t index = 0; index < count; ++index)
 		{
-			throw std::runtime_error("Symbol already defined");
+			auto slot = slotOf(entry(index).first, mask);
+			while(slots[slot] != emptySlot)
+			{
+				slot = (slot + 1) & mask;
+			}
+			slots[slot] = index;
 		}
-		else
+	}
+
+	SymbolTable::Symbol& SymbolTable::operator[](SymbolId key)
+	{
+		if(auto symbol = lookup(key))
 		{
-			return table[key] = v;
+			return *symbol;
 		}
+		throw std::runtime_error("Symbol not found");
 	}
 
-	SymbolTable& SymbolTable::addChild(std::unique_ptr<SymbolTable> child)
+	SymbolTable::Symbol* SymbolTable::lookup(SymbolId key)
 	{
-		child->parent = this;
-		children.push_back(std::move(child));
-		return *children.back();
+		// Loop instead of recursing into the parent, scopes can nest arbitrarily deep
+		for(auto scope = this; scope != nullptr; scope = scope->parent)
+		{
+			if(auto index = scope->find(key); index != emptySlot)
+			{
+				return &scope->entry(index).second;
+			}
+		}
+		return nullptr;
+	}
+
+	bool SymbolTable::declares(SymbolId key) const
+	{
+		return find(key) != emptySlot;
 	}
 
-	RecursiveSymTableIterator SymbolTable::begin()
+	SymbolTable::Symbol& SymbolTable::insert(SymbolId key, SymbolTable::Symbol v)
 	{
-		return RecursiveSymTableIterator{this};
+		if(find(key) != emptySlot)
+		{
+			throw std::runtime_error("Symbol already defined");
+		}
+		if(chunks.empty() || chunks.back().size() == chunks.back().capacity())
+		{
+			auto size = firstChunkSize << chunks.size();
+			chunks.emplace_back().reserve(size);
+		}
+		auto& symbol = chunks.back().emplace_back(key, std::move(v)).second;
+		++count;
+
+		if(count * 2 > slots.size())
+		{
+			grow();
+		}
+		else
+		{
+			auto mask = slots.size() - 1;
+			auto slot = slotOf(key, mask);
+			while(slots[slot] != emptySlot)
+			{
+				slot = (slot + 1) & mask;
+			}
+			slots[slot] = count - 1;
+		}
+		return symbol;
 	}
 
-	RecursiveSymTableIterator SymbolTable::end()
+	SymbolTable& SymbolTable::addChild(std::unique_ptr<SymbolTable> child)
 	{
-		return RecursiveSymTableIterator{};
+		child->parent = this;
+		children.push_back(std::move(child));
+		return *children.back();
 	}
 
 	std::size_t SymbolTable::numChildren()
 	{
-		return table.size();
+		return children.size();
 	}
 
 	SymbolTable& SymbolTable::getChild(std::size_t indx)
@@ -100,56 +178,4 @@ namespace intermediate_rep
 	{
 		builder.pop();
 	}
-
-	RecursiveSymTableIterator::RecursiveSymTableIterator(SymbolTable* sym_table):
-		begin{sym_table->table.begin()}, end{sym_table->table.end()}
-	{
-		if(begin != end)
-		{
-			stack.push(sym_table);
-		}
-	}
-
-	decltype(SymbolTable::table)::value_type& RecursiveSymTableIterator::operator*()
-	{
-		return *begin;
-	}
-	
-	RecursiveSymTableIterator& RecursiveSymTableIterator::operator++()
-	{
-		++begin;
-		if(begin == end && stack.size() > 0)
-		{
-			auto top = stack.top();
-			stack.pop();
-			for(auto& childPtr : top->children)
-			{
-				stack.push(childPtr.get());
-			}
-			if(stack.size() > 0)
-			{
-				begin = top->table.begin();
-				end = top->table.end();
-			}
-		}
-			
-		return *this;
-	}
-	
-	RecursiveSymTableIterator RecursiveSymTableIterator::operator++(int)
-	{
-		auto copy = *this;
-		++(*this);
-		return copy;
-	}
-
-	bool RecursiveSymTableIterator::operator!=(const RecursiveSymTableIterator& other)
-	{
-		return stack.size() > 0;
-	}
-
-
-
-
-
 }
\ No newline at end of file
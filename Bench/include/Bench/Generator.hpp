@@ -0,0 +1,35 @@
+#ifndef generator_hpp
+#define generator_hpp
+#include <string>
+
+namespace bench
+{
+	// Shape of a synthetic program.
+	// The same options and seed always produce the same source text.
+	struct GeneratorOptions
+	{
+		unsigned functions = 200;
+		unsigned statementsPerFunction = 40;
+		unsigned expressionDepth = 4;
+		unsigned identifierLength = 8;
+		unsigned nestingDepth = 3;
+		unsigned seed = 1;
+	};
+
+	// Builds a program the parser accepts: every name is declared before use
+	// and functions only call functions defined above them.
+	std::string generateProgram(const GeneratorOptions& options);
+
+	// Shape of a program the code generator can compile: one int function made of many small
+	// basic blocks, with every variable of it declared in the function's scope.
+	struct BlockProgramOptions
+	{
+		unsigned variables = 2000;
+		unsigned seed = 1;
+	};
+
+	// Each variable adds its declaration and an if statement, two basic blocks in total
+	std::string generateBlockProgram(const BlockProgramOptions& options);
+}
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef measure_hpp
+#define measure_hpp
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace bench
+{
+	// Runs work warmup + repetitions times and keeps the timings of the repetitions.
+	// Whatever work returns is destroyed after the clock stopped.
+	template<typename Work>
+	auto measure(unsigned warmup, unsigned repetitions, Work work) -> std::vector<double>
+	{
+		for(unsigned i = 0; i < warmup; ++i)
+		{
+			work();
+		}
+
+		std::vector<double> seconds;
+		for(unsigned i = 0; i < repetitions; ++i)
+		{
+			auto start = std::chrono::steady_clock::now();
+			[[maybe_unused]] auto result = work();
+			auto end = std::chrono::steady_clock::now();
+			seconds.push_back(std::chrono::duration<double>(end - start).count());
+		}
+		return seconds;
+	}
+
+	inline auto median(std::vector<double> values) -> double
+	{
+		std::sort(values.begin(), values.end());
+		auto mid = values.size() / 2;
+		return values.size() % 2 ? values[mid] : (values[mid - 1] + values[mid]) / 2;
+	}
+}
+
+#endif
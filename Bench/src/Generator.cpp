@@ -0,0 +1,280 @@
+#include "Generator.hpp"
+#include <random>
+#include <vector>
+#include <array>
+#include <string_view>
+
+namespace bench
+{
+	namespace
+	{
+		constexpr std::array<std::string_view, 3> typeNames{"int", "float", "bool"};
+		constexpr std::array<std::string_view, 11> binaryOperators{"+", "-", "*", "/", "<", "<=", ">", ">=", "==", "and", "or"};
+
+		struct Callee
+		{
+			std::string name;
+			unsigned parameters;
+		};
+
+		class Generator
+		{
+		public:
+			Generator(const GeneratorOptions& options):
+				options{options}, rng{options.seed}
+			{}
+
+			std::string program()
+			{
+				for(unsigned i = 0; i < options.functions; ++i)
+				{
+					function();
+				}
+				return std::move(out);
+			}
+
+		private:
+			// Raw engine output is fully specified by the standard, unlike the distributions
+			unsigned pick(unsigned n)
+			{
+				return n == 0 ? 0 : rng() % n;
+			}
+
+			std::string identifier(char prefix)
+			{
+				std::string name(1, prefix);
+				name += std::to_string(nameCounter++);
+				for(char c = 'a'; name.size() < options.identifierLength; c = c == 'z' ? 'a' : c + 1)
+				{
+					name += c;
+				}
+				return name;
+			}
+
+			void indent(unsigned depth)
+			{
+				out.append(depth + 1, '\t');
+			}
+
+			void function()
+			{
+				Callee callee{identifier('f'), pick(4)};
+				out += typeNames[pick(typeNames.size())];
+				out += ' ';
+				out += callee.name;
+				out += '(';
+				for(unsigned i = 0; i < callee.parameters; ++i)
+				{
+					if(i != 0)
+					{
+						out += ", ";
+					}
+					auto name = identifier('p');
+					out += typeNames[pick(typeNames.size())];
+					out += ' ';
+					out += name;
+					scope.push_back(std::move(name));
+				}
+				out += ")\n{\n";
+
+				remaining = options.statementsPerFunction;
+				while(remaining > 1)
+				{
+					stmt(0);
+				}
+				indent(0);
+				out += "return ";
+				expr(options.expressionDepth);
+				out += ";\n}\n\n";
+
+				scope.clear();
+				callees.push_back(std::move(callee));
+			}
+
+			void stmt(unsigned depth)
+			{
+				--remaining;
+				indent(depth);
+				bool nest = depth < options.nestingDepth && remaining > 1;
+				switch(pick(nest ? 6 : 3))
+				{
+					case 0:
+					{
+						auto name = identifier('v');
+						out += typeNames[pick(typeNames.size())];
+						out += ' ';
+						out += name;
+						out += " = ";
+						expr(options.expressionDepth);
+						out += ";\n";
+						scope.push_back(std::move(name));
+						break;
+					}
+					case 1:
+						if(!scope.empty())
+						{
+							out += scope[pick(scope.size())];
+							out += " = ";
+						}
+						expr(options.expressionDepth);
+						out += ";\n";
+						break;
+					case 2:
+						if(!callees.empty())
+						{
+							call();
+						}
+						else
+						{
+							expr(options.expressionDepth);
+						}
+						out += ";\n";
+						break;
+					case 3:
+					case 4:
+						out += "if(";
+						expr(options.expressionDepth);
+						out += ")\n";
+						block(depth);
+						if(pick(2) == 0 && remaining > 1)
+						{
+							indent(depth);
+							out += "else\n";
+							block(depth);
+						}
+						break;
+					default:
+						out += "while(";
+						expr(options.expressionDepth);
+						out += ")\n";
+						block(depth);
+						break;
+				}
+			}
+
+			void block(unsigned depth)
+			{
+				indent(depth);
+				out += "{\n";
+				auto outer = scope.size();
+				for(unsigned i = 1 + pick(4); i > 0 && remaining > 1; --i)
+				{
+					stmt(depth + 1);
+				}
+				scope.resize(outer);
+				indent(depth);
+				out += "}\n";
+			}
+
+			void expr(unsigned depth)
+			{
+				if(depth == 0 || pick(4) == 0)
+				{
+					leaf();
+					return;
+				}
+				bool parens = pick(3) == 0;
+				if(parens)
+				{
+					out += '(';
+				}
+				expr(depth - 1);
+				out += ' ';
+				out += binaryOperators[pick(binaryOperators.size())];
+				out += ' ';
+				expr(depth - 1);
+				if(parens)
+				{
+					out += ')';
+				}
+			}
+
+			void leaf()
+			{
+				switch(pick(8))
+				{
+					case 0:
+					case 1:
+					case 2:
+						if(!scope.empty())
+						{
+							out += scope[pick(scope.size())];
+							return;
+						}
+						[[fallthrough]];
+					case 3:
+						out += std::to_string(pick(100000));
+						return;
+					case 4:
+						out += std::to_string(pick(1000));
+						out += '.';
+						out += std::to_string(pick(100));
+						return;
+					case 5:
+						out += pick(2) ? "true" : "false";
+						return;
+					case 6:
+						out += "\"str";
+						out += std::to_string(pick(100));
+						out += '"';
+						return;
+					default:
+						if(!callees.empty())
+						{
+							call();
+						}
+						else
+						{
+							out += '0';
+						}
+						return;
+				}
+			}
+
+			void call()
+			{
+				auto& callee = callees[pick(callees.size())];
+				out += callee.name;
+				out += '(';
+				for(unsigned i = 0; i < callee.parameters; ++i)
+				{
+					if(i != 0)
+					{
+						out += ", ";
+					}
+					leaf();
+				}
+				out += ')';
+			}
+
+			const GeneratorOptions& options;
+			std::mt19937 rng;
+			std::string out;
+			std::vector<std::string> scope;
+			std::vector<Callee> callees;
+			unsigned nameCounter = 0;
+			unsigned remaining = 0;
+		};
+	}
+
+	std::string generateProgram(const GeneratorOptions& options)
+	{
+		return Generator{options}.program();
+	}
+
+	std::string generateBlockProgram(const BlockProgramOptions& options)
+	{
+		std::mt19937 rng{options.seed};
+		std::string out = "int main()\n{\n";
+		for(unsigned i = 0; i < options.variables; ++i)
+		{
+			auto name = "v" + std::to_string(i);
+			auto other = "v" + std::to_string(rng() % (i + 1));
+			out += "\tint " + name + " = " + std::to_string(i) + ";\n";
+			out += "\tif(" + name + " < " + other + ")\n\t{\n";
+			out += "\t\t" + name + " = " + other + " + 1;\n\t}\n";
+		}
+		out += "\treturn v0;\n}\n";
+		return out;
+	}
+}
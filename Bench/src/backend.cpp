@@ -0,0 +1,194 @@
+#include "Generator.hpp"
+#include "Measure.hpp"
+#include "Ast/Ast.hpp"
+#include "Lexer/Lexer.hpp"
+#include "Parser/Parser.hpp"
+#include "TacGenerator/TacGenerator.hpp"
+#include "AsmGenerator/AsmGenerator.hpp"
+#include "Tac/CompactTac.hpp"
+#include "Token/TokenBuffer.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// Code generator throughput benchmark.
+// Runs AsmGenerator::gen over one function with thousands of basic blocks and variables
+// and reports the median run, as text or as JSON for tracking regressions between versions.
+// Also reports the memory per instruction of the TAC as Quadruples and in compact form.
+
+namespace
+{
+	using namespace intermediate_rep;
+
+	struct Options
+	{
+		bench::BlockProgramOptions program;
+		unsigned warmup = 1;
+		unsigned repetitions = 5;
+		bool json = false;
+	};
+
+	auto parseOptions(int argc, char** argv) -> Options
+	{
+		Options options;
+		const std::pair<std::string_view, unsigned*> numbers[]
+		{
+			{"--variables", &options.program.variables},
+			{"--seed", &options.program.seed},
+			{"--warmup", &options.warmup},
+			{"--repetitions", &options.repetitions},
+		};
+
+		for(int i = 1; i < argc; ++i)
+		{
+			std::string_view arg = argv[i];
+			if(arg == "--json")
+			{
+				options.json = true;
+				continue;
+			}
+
+			auto number = std::find_if(std::begin(numbers), std::end(numbers), [&](auto& n){ return n.first == arg; });
+			if(number == std::end(numbers))
+			{
+				throw std::runtime_error("Unknown option: " + std::string{arg});
+			}
+			if(i + 1 >= argc)
+			{
+				throw std::runtime_error("Missing value for " + std::string{arg});
+			}
+			*number->second = static_cast<unsigned>(std::stoul(argv[++i]));
+		}
+		options.repetitions = std::max(1u, options.repetitions);
+		return options;
+	}
+
+	// Characters kept outside of the string object
+	auto heapBytes(const std::string& text) -> std::size_t
+	{
+		auto object = reinterpret_cast<const char*>(&text);
+		bool local = text.data() >= object && text.data() < object + sizeof(text);
+		return local ? 0 : text.capacity() + 1;
+	}
+
+	auto memory(const tac::Function& function) -> std::size_t
+	{
+		auto bytes = function.tac.size() * sizeof(tac::Quadruple);
+		for(auto& quad : function.tac)
+		{
+			bytes += heapBytes(quad.label);
+			for(auto address : {&quad.result, &quad.arg1, &quad.arg2})
+			{
+				if(auto label = std::get_if<tac::Label>(address))
+				{
+					bytes += heapBytes(*label);
+				}
+			}
+		}
+		return bytes;
+	}
+
+	auto memory(const tac::CompactFunction& function) -> std::size_t
+	{
+		auto bytes = function.code.size() * sizeof(tac::Instruction)
+			+ function.variables.size() * sizeof(function.variables[0])
+			+ function.functions.size() * sizeof(function.functions[0])
+			+ function.ints.size() * sizeof(int)
+			+ function.doubles.size() * sizeof(double)
+			+ function.labels.size() * sizeof(tac::Label);
+		for(auto& label : function.labels)
+		{
+			bytes += heapBytes(label);
+		}
+		return bytes;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	try
+	{
+		auto options = parseOptions(argc, argv);
+		auto program = bench::generateBlockProgram(options.program);
+
+		Interner names;
+		TokenBuffer buffer;
+		Lexer::Lexer{program, names}.tokenizeAll(buffer);
+		Parser::Parser parser{buffer};
+		auto ast = parser.program();
+		auto functions = tac_gen::TacGenerator{&ast}.gen();
+
+		std::size_t quadruples = 0;
+		std::size_t blocks = 0;
+		std::size_t quadrupleBytes = 0;
+		std::size_t compactBytes = 0;
+		for(auto& function : functions)
+		{
+			auto compact = tac::compact(function);
+			quadrupleBytes += memory(function);
+			compactBytes += memory(compact);
+		}
+		{
+			std::ostream discard{nullptr};
+			assembly::AsmGenerator generator{functions, discard};
+			for(auto& function : functions)
+			{
+				quadruples += function.tac.size();
+				blocks += generator.getBasicBlocks(function).size();
+			}
+		}
+
+		// The assembly goes into a stream without buffer, so formatting is all that is left of the output
+		auto seconds = bench::measure(options.warmup, options.repetitions, [&]()
+		{
+			std::ostream discard{nullptr};
+			assembly::AsmGenerator generator{functions, discard};
+			generator.gen();
+			return 0;
+		});
+		auto time = bench::median(seconds);
+
+		if(options.json)
+		{
+			std::cout << "{\n"
+			   << "\t\"program\": {\"variables\": " << options.program.variables
+			   << ", \"blocks\": " << blocks
+			   << ", \"quadruples\": " << quadruples
+			   << ", \"seed\": " << options.program.seed << "},\n"
+			   << "\t\"warmup\": " << options.warmup << ",\n"
+			   << "\t\"repetitions\": " << options.repetitions << ",\n"
+			   << "\t\"results\": [\n"
+			   << "\t\t{\"name\": \"codegen\""
+			   << ", \"median_seconds\": " << time
+			   << ", \"min_seconds\": " << *std::min_element(seconds.begin(), seconds.end())
+			   << ", \"blocks_per_second\": " << blocks / time
+			   << ", \"quadruples_per_second\": " << quadruples / time
+			   << "}\n\t],\n"
+			   << "\t\"memory\": {\"quadruple_bytes_per_instruction\": " << double(quadrupleBytes) / quadruples
+			   << ", \"compact_bytes_per_instruction\": " << double(compactBytes) / quadruples
+			   << "}\n}\n";
+		}
+		else
+		{
+			std::cout << "program: " << options.program.variables << " variables, "
+			   << blocks << " basic blocks, " << quadruples << " quadruples\n"
+			   << "codegen: " << time * 1e3 << " ms median, "
+			   << blocks / time << " blocks/s, "
+			   << quadruples / time << " quadruples/s\n"
+			   << "memory: " << double(quadrupleBytes) / quadruples << " bytes/instruction as Quadruples, "
+			   << double(compactBytes) / quadruples << " compact\n";
+		}
+	}
+	catch(const std::exception& e)
+	{
+		std::cerr << e.what() << '\n';
+		return EXIT_FAILURE;
+	}
+}
@@ -0,0 +1,270 @@
+#include "Generator.hpp"
+#include "Measure.hpp"
+#include "Ast/Ast.hpp"
+#include "Lexer/Lexer.hpp"
+#include "Parser/Parser.hpp"
+#include "Token/Token.hpp"
+#include "Token/TokenBuffer.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+
+// Front end throughput benchmark.
+// Lexes and parses a generated program a number of times and reports the
+// median run, as text or as JSON for tracking regressions between versions.
+
+namespace
+{
+	using namespace intermediate_rep;
+
+	struct Options
+	{
+		bench::GeneratorOptions program;
+		unsigned warmup = 2;
+		unsigned repetitions = 10;
+		bool json = false;
+	};
+
+	struct Result
+	{
+		std::string name;
+		std::vector<double> seconds;
+		std::size_t bytes = 0;
+		std::size_t items = 0;
+		std::string itemName;
+	};
+
+	// Counts every expression and statement node of a program
+	struct NodeCounter
+	{
+		std::size_t nodes = 0;
+
+		void visit(ast::BinaryExpression& e)
+		{
+			++nodes;
+			e.left->accept(*this);
+			e.right->accept(*this);
+		}
+		void visit(ast::UnaryExpression& e)
+		{
+			++nodes;
+			e.expr->accept(*this);
+		}
+		void visit(ast::Variable&) { ++nodes; }
+		void visit(ast::Constant<int>&) { ++nodes; }
+		void visit(ast::Constant<double>&) { ++nodes; }
+		void visit(ast::Constant<bool>&) { ++nodes; }
+		void visit(ast::Constant<std::string_view>&) { ++nodes; }
+		void visit(ast::Call& e)
+		{
+			++nodes;
+			for(auto& arg : e.args)
+			{
+				arg->accept(*this);
+			}
+		}
+
+		void visit(ast::ExprStmt& s)
+		{
+			++nodes;
+			s.expr->accept(*this);
+		}
+		void visit(ast::IfStmt& s)
+		{
+			++nodes;
+			s.condition->accept(*this);
+			s.trueStmt->accept(*this);
+			if(s.falseStmt)
+			{
+				s.falseStmt->accept(*this);
+			}
+		}
+		void visit(ast::WhileStmt& s)
+		{
+			++nodes;
+			s.condition->accept(*this);
+			s.stmt->accept(*this);
+		}
+		void visit(ast::ReturnStmt& s)
+		{
+			++nodes;
+			if(s.expr)
+			{
+				s.expr->accept(*this);
+			}
+		}
+		void visit(ast::Block& s)
+		{
+			++nodes;
+			for(auto& stmt : s.stmts)
+			{
+				stmt->accept(*this);
+			}
+		}
+
+		std::size_t count(ast::Program& program)
+		{
+			for(auto& function : program.functions)
+			{
+				++nodes;
+				function.block->accept(*this);
+			}
+			return nodes;
+		}
+	};
+
+	auto parseOptions(int argc, char** argv) -> Options
+	{
+		Options options;
+		const std::pair<std::string_view, unsigned*> numbers[]
+		{
+			{"--functions", &options.program.functions},
+			{"--statements", &options.program.statementsPerFunction},
+			{"--expr-depth", &options.program.expressionDepth},
+			{"--ident-length", &options.program.identifierLength},
+			{"--nesting", &options.program.nestingDepth},
+			{"--seed", &options.program.seed},
+			{"--warmup", &options.warmup},
+			{"--repetitions", &options.repetitions},
+		};
+
+		for(int i = 1; i < argc; ++i)
+		{
+			std::string_view arg = argv[i];
+			if(arg == "--json")
+			{
+				options.json = true;
+				continue;
+			}
+
+			auto number = std::find_if(std::begin(numbers), std::end(numbers), [&](auto& n){ return n.first == arg; });
+			if(number == std::end(numbers))
+			{
+				throw std::runtime_error("Unknown option: " + std::string{arg});
+			}
+			if(i + 1 >= argc)
+			{
+				throw std::runtime_error("Missing value for " + std::string{arg});
+			}
+			*number->second = static_cast<unsigned>(std::stoul(argv[++i]));
+		}
+		options.repetitions = std::max(1u, options.repetitions);
+		return options;
+	}
+
+	void printText(std::ostream& os, const Options& options, std::size_t bytes, const std::vector<Result>& results)
+	{
+		os << "program: " << bytes << " bytes, "
+		   << options.program.functions << " functions, "
+		   << options.program.statementsPerFunction << " statements per function\n";
+		for(auto& result : results)
+		{
+			auto time = bench::median(result.seconds);
+			os << result.name << ": " << time * 1e3 << " ms median, "
+			   << result.bytes / time / 1e6 << " MB/s, "
+			   << result.items / time << ' ' << result.itemName << "/s\n";
+		}
+	}
+
+	void printJson(std::ostream& os, const Options& options, std::size_t bytes, const std::vector<Result>& results)
+	{
+		auto& p = options.program;
+		os << "{\n"
+		   << "\t\"program\": {\"bytes\": " << bytes
+		   << ", \"functions\": " << p.functions
+		   << ", \"statements\": " << p.statementsPerFunction
+		   << ", \"expr_depth\": " << p.expressionDepth
+		   << ", \"ident_length\": " << p.identifierLength
+		   << ", \"nesting\": " << p.nestingDepth
+		   << ", \"seed\": " << p.seed << "},\n"
+		   << "\t\"warmup\": " << options.warmup << ",\n"
+		   << "\t\"repetitions\": " << options.repetitions << ",\n"
+		   << "\t\"results\": [\n";
+		for(std::size_t i = 0; i < results.size(); ++i)
+		{
+			auto& result = results[i];
+			auto time = bench::median(result.seconds);
+			os << "\t\t{\"name\": \"" << result.name << "\""
+			   << ", \"median_seconds\": " << time
+			   << ", \"min_seconds\": " << *std::min_element(result.seconds.begin(), result.seconds.end())
+			   << ", \"mb_per_second\": " << result.bytes / time / 1e6
+			   << ", \"" << result.itemName << "\": " << result.items
+			   << ", \"" << result.itemName << "_per_second\": " << result.items / time
+			   << "}" << (i + 1 < results.size() ? "," : "") << '\n';
+		}
+		os << "\t]\n}\n";
+	}
+}
+
+int main(int argc, char** argv)
+{
+	try
+	{
+		auto options = parseOptions(argc, argv);
+		auto program = bench::generateProgram(options.program);
+
+		std::vector<Result> results;
+
+		// Lexer::next over the whole program, including interning of identifiers
+		std::size_t tokens = 0;
+		auto lexTimes = bench::measure(options.warmup, options.repetitions, [&]()
+		{
+			auto names = std::make_unique<Interner>();
+			Lexer::Lexer lexer{program, *names};
+			tokens = 0;
+			while(lexer.next().type != Token::Type::Eof)
+			{
+				++tokens;
+			}
+			return names;
+		});
+		results.push_back({"lexer", std::move(lexTimes), program.size(), tokens, "tokens"});
+
+		// Parser::program from pre lexed tokens, so only the parser is measured
+		Interner names;
+		TokenBuffer buffer;
+		Lexer::Lexer{program, names}.tokenizeAll(buffer);
+
+		std::size_t nodes = 0;
+		{
+			Parser::Parser parser{buffer};
+			auto ast = parser.program();
+			nodes = NodeCounter{}.count(ast);
+		}
+
+		auto parseTimes = bench::measure(options.warmup, options.repetitions, [&]()
+		{
+			Parser::Parser parser{buffer};
+			return parser.program();
+		});
+		results.push_back({"parser", std::move(parseTimes), program.size(), nodes, "nodes"});
+
+		// Parser::programParallel on the same tokens, signatures first, then the bodies on all cores
+		auto parallelParseTimes = bench::measure(options.warmup, options.repetitions, [&]()
+		{
+			Parser::Parser parser{buffer};
+			return parser.programParallel();
+		});
+		results.push_back({"parser-parallel", std::move(parallelParseTimes), program.size(), nodes, "nodes"});
+
+		if(options.json)
+		{
+			printJson(std::cout, options, program.size(), results);
+		}
+		else
+		{
+			printText(std::cout, options, program.size(), results);
+		}
+	}
+	catch(const std::exception& e)
+	{
+		std::cerr << e.what() << '\n';
+		return EXIT_FAILURE;
+	}
+}
@@ -0,0 +1,193 @@
+#ifndef cache_hpp
+#define cache_hpp
+#include "Ast/Ast.hpp"
+#include "Ast/FlatAst.hpp"
+#include "Ast/SymbolTable.hpp"
+#include "Tac/Tac.hpp"
+#include "Token/Interner.hpp"
+#include "Lexer/SourceFile.hpp"
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <variant>
+#include <stdexcept>
+
+namespace cache
+{
+	namespace ast = intermediate_rep::ast;
+	namespace tac = intermediate_rep::tac;
+
+	// Binary cache of a compiled program: the symbol tables, the AST in flat form and the TAC.
+	// The file is a header followed by sections of fixed size records. Records refer to each
+	// other by index only, so the file is position independent and can be used straight from
+	// a read only mapping. Files of another version or for another source are not loaded.
+
+	inline constexpr std::uint32_t version = 3;
+
+	inline constexpr std::uint32_t noIndex = std::numeric_limits<std::uint32_t>::max();
+
+	enum class Section : std::uint32_t
+	{
+		Chars,			// characters of all strings
+		Names,			// StringRecord per SymbolId of the Interner
+		Scopes,			// ScopeRecord, in preorder, scope 0 is the root
+		Symbols,		// SymbolRecord, grouped by scope
+		Parameters,		// symbol indices of function parameters
+		Nodes,			// ast::Node, as in FlatAst::nodes
+		Lists,			// as in FlatAst::lists
+		Variables,		// symbol index per FlatAst::variables
+		Functions,		// symbol index per FlatAst::functions
+		Floats,			// as in FlatAst::floats
+		Strings,		// StringRecord per FlatAst::strings
+		Bodies,			// BodyRecord per function of the program
+		Labels,			// StringRecord per TAC label
+		Quadruples,		// QuadrupleRecord of all TAC functions
+		TacFunctions,	// TacFunctionRecord
+		Temporaries,	// TemporaryRecord of all TAC functions
+		Count
+	};
+
+	struct SectionRecord
+	{
+		std::uint64_t offset;	// in bytes from the start of the file
+		std::uint64_t size;		// in bytes
+	};
+
+	struct Header
+	{
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t sectionCount;
+		std::uint64_t sourceHash;
+		SectionRecord sections[static_cast<std::size_t>(Section::Count)];
+	};
+
+	struct StringRecord
+	{
+		std::uint32_t offset;	// into Chars
+		std::uint32_t size;
+	};
+
+	struct ScopeRecord
+	{
+		std::uint32_t parent;	// noIndex for the root
+		std::uint32_t firstSymbol;
+		std::uint32_t symbolCount;
+	};
+
+	struct SymbolRecord
+	{
+		enum Kind : std::uint8_t
+		{
+			Variable, Function
+		};
+		Kind kind;
+		std::uint8_t type;		// Variable::Type, the return type of functions
+		std::uint32_t name;		// SymbolId
+		std::uint32_t scope;	// parameter scope of functions
+		std::uint32_t firstParameter;
+		std::uint32_t parameterCount;
+	};
+
+	struct BodyRecord
+	{
+		std::uint32_t function;	// symbol index
+		ast::NodeId body;
+	};
+
+	// One tac::Address, tag is the index of the alternative in the variant,
+	// or temporaryTag for variables that are temporaries of the function
+	struct OperandRecord
+	{
+		std::uint8_t tag;
+		std::uint64_t value;	// symbol index, constant, label index, argument count or temporary index
+	};
+
+	inline constexpr std::uint8_t temporaryTag = std::variant_size_v<tac::Address>;
+
+	struct QuadrupleRecord
+	{
+		std::uint32_t label;	// noIndex for none
+		std::uint8_t instr;
+		OperandRecord result;
+		OperandRecord arg1;
+		OperandRecord arg2;
+	};
+
+	struct TacFunctionRecord
+	{
+		std::uint32_t function;	// symbol index
+		std::uint32_t firstQuadruple;
+		std::uint32_t quadrupleCount;
+		std::uint32_t firstTemporary;
+		std::uint32_t temporaryCount;
+	};
+
+	struct TemporaryRecord
+	{
+		std::uint32_t number;
+		std::uint8_t type;		// Variable::Type
+	};
+
+	// Hash of the program text a cache was made from
+	std::uint64_t hashSource(std::string_view program);
+
+	// Writes program and functions, which were generated from it, to path.
+	void write(const std::string& path, std::uint64_t sourceHash, ast::Program& program, const std::vector<tac::Function>& functions);
+
+	// Program and TAC restored from a cache, the TAC refers to the symbol tables of program
+	struct Compilation
+	{
+		ast::Program program;
+		std::vector<tac::Function> functions;
+	};
+
+	// Read only mapping of a cache file. Throws std::runtime_error if the file is not a
+	// cache of this version or is damaged. The sections are used in place.
+	class CacheFile
+	{
+	public:
+		explicit CacheFile(const std::string& path);
+
+		std::uint64_t sourceHash() const
+		{
+			return header().sourceHash;
+		}
+
+		template<typename T>
+		std::span<const T> section(Section which) const
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			auto& record = header().sections[static_cast<std::size_t>(which)];
+			return {reinterpret_cast<const T*>(file.view().data() + record.offset), record.size / sizeof(T)};
+		}
+
+		std::string_view string(StringRecord record) const
+		{
+			auto chars = section<char>(Section::Chars);
+			if(record.offset > chars.size() || record.size > chars.size() - record.offset)
+			{
+				throw std::runtime_error("Damaged cache file");
+			}
+			return {chars.data() + record.offset, record.size};
+		}
+
+		// Builds the symbol tables, the AST and the TAC, the names go into names
+		auto load(intermediate_rep::Interner& names) const -> Compilation;
+
+	private:
+		const Header& header() const
+		{
+			return *reinterpret_cast<const Header*>(file.view().data());
+		}
+
+		Lexer::SourceFile file;
+	};
+}
+
+#endif
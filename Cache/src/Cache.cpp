@@ -0,0 +1,624 @@
+#include "Cache.hpp"
+#include <bit>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+
+namespace cache
+{
+	using namespace intermediate_rep;
+
+	namespace
+	{
+		constexpr char magic[8] = {'L', 'A', 'N', 'G', 'I', 'R', '\0', '\0'};
+
+		constexpr std::size_t sectionCount = static_cast<std::size_t>(Section::Count);
+
+		// Sections start at multiples of this, enough for every record
+		constexpr std::size_t sectionAlignment = 8;
+
+		static_assert(std::is_trivially_copyable_v<ast::Node>, "Nodes are stored bytewise");
+
+		[[noreturn]] void damaged()
+		{
+			throw std::runtime_error("Damaged cache file");
+		}
+
+		// Bounds checked access, the file may be truncated or corrupt
+		template<typename T>
+		const T& at(std::span<const T> values, std::uint64_t index)
+		{
+			if(index >= values.size())
+			{
+				damaged();
+			}
+			return values[index];
+		}
+
+		struct Writer
+		{
+			std::vector<char> chars;
+			std::vector<StringRecord> names;
+			std::vector<ScopeRecord> scopes;
+			std::vector<SymbolRecord> symbols;
+			std::vector<std::uint32_t> parameters;
+			std::vector<std::uint32_t> variables;
+			std::vector<std::uint32_t> functions;
+			std::vector<StringRecord> strings;
+			std::vector<BodyRecord> bodies;
+			std::vector<StringRecord> labels;
+			std::vector<QuadrupleRecord> quadruples;
+			std::vector<TacFunctionRecord> tacFunctions;
+			std::vector<TemporaryRecord> temporaries;
+
+			// Symbol index of every Variable and Function
+			std::unordered_map<const void*, std::uint32_t> symbolIndex;
+			std::unordered_map<const SymbolTable*, std::uint32_t> scopeIndex;
+			std::unordered_map<std::string_view, std::uint32_t> labelIndex;
+			// Index of the temporaries of the function being written
+			std::unordered_map<const SymbolTable::Variable*, std::uint32_t> temporaryIndex;
+
+			StringRecord string(std::string_view text)
+			{
+				StringRecord record{static_cast<std::uint32_t>(chars.size()), static_cast<std::uint32_t>(text.size())};
+				chars.insert(chars.end(), text.begin(), text.end());
+				return record;
+			}
+
+			std::uint32_t symbol(const void* entry)
+			{
+				auto iter = symbolIndex.find(entry);
+				if(iter == symbolIndex.end())
+				{
+					throw std::runtime_error("Symbol outside of the program's symbol tables");
+				}
+				return iter->second;
+			}
+
+			std::uint32_t label(const tac::Label& text)
+			{
+				auto [iter, inserted] = labelIndex.try_emplace(text, static_cast<std::uint32_t>(labels.size()));
+				if(inserted)
+				{
+					labels.push_back(string(text));
+				}
+				return iter->second;
+			}
+
+			// Scopes in preorder, with an explicit stack since scopes can nest arbitrarily deep
+			void symbolTables(SymbolTable& root)
+			{
+				std::vector<std::pair<SymbolTable*, std::uint32_t>> stack{{&root, noIndex}};
+				std::vector<std::pair<std::uint32_t, SymbolTable::Function*>> withParameters;
+				while(!stack.empty())
+				{
+					auto [scope, parent] = stack.back();
+					stack.pop_back();
+
+					auto index = static_cast<std::uint32_t>(scopes.size());
+					scopeIndex.emplace(scope, index);
+					auto first = static_cast<std::uint32_t>(symbols.size());
+					for(auto& [id, entry] : scope->non_rec_view())
+					{
+						symbolIndex.emplace(std::visit([](auto& e) -> const void* { return &e; }, entry), static_cast<std::uint32_t>(symbols.size()));
+						if(auto var = std::get_if<SymbolTable::Variable>(&entry))
+						{
+							symbols.push_back({SymbolRecord::Variable, static_cast<std::uint8_t>(var->type), id, noIndex, 0, 0});
+						}
+						else
+						{
+							auto& func = std::get<SymbolTable::Function>(entry);
+							withParameters.emplace_back(static_cast<std::uint32_t>(symbols.size()), &func);
+							symbols.push_back({SymbolRecord::Function, static_cast<std::uint8_t>(func.returnType), id, noIndex, 0, 0});
+						}
+					}
+					scopes.push_back({parent, first, static_cast<std::uint32_t>(symbols.size() - first)});
+
+					// Reversed, so the children come out in order
+					for(auto i = scope->numChildren(); i-- > 0;)
+					{
+						stack.emplace_back(&scope->getChild(i), index);
+					}
+				}
+
+				// Parameter scopes come after the scope of their function, so all have an index by now
+				for(auto [index, func] : withParameters)
+				{
+					auto& record = symbols[index];
+					record.scope = func->parameter_scope ? scopeIndex.at(func->parameter_scope) : noIndex;
+					record.firstParameter = static_cast<std::uint32_t>(parameters.size());
+					record.parameterCount = static_cast<std::uint32_t>(func->parameters.size());
+					for(auto param : func->parameters)
+					{
+						parameters.push_back(symbol(param));
+					}
+				}
+			}
+
+			void flatAst(const ast::FlatAst& flat)
+			{
+				for(auto var : flat.variables)
+				{
+					variables.push_back(symbol(var));
+				}
+				for(auto func : flat.functions)
+				{
+					functions.push_back(symbol(func));
+				}
+				for(auto str : flat.strings)
+				{
+					strings.push_back(string(str));
+				}
+				for(auto& body : flat.bodies)
+				{
+					bodies.push_back({symbol(body.sym_entry), body.body});
+				}
+			}
+
+			OperandRecord operand(const tac::Address& address)
+			{
+				struct Encoder
+				{
+					Writer& writer;
+
+					auto operator()(const std::monostate&) -> std::uint64_t
+					{
+						return 0;
+					}
+					auto operator()(SymbolTable::Variable* var) -> std::uint64_t
+					{
+						return writer.symbol(var);
+					}
+					auto operator()(SymbolTable::Function* func) -> std::uint64_t
+					{
+						return writer.symbol(func);
+					}
+					auto operator()(const tac::Constant<int>& c) -> std::uint64_t
+					{
+						return static_cast<std::uint64_t>(static_cast<std::int64_t>(c.value));
+					}
+					auto operator()(const tac::Constant<double>& c) -> std::uint64_t
+					{
+						return std::bit_cast<std::uint64_t>(c.value);
+					}
+					auto operator()(const tac::Constant<bool>& c) -> std::uint64_t
+					{
+						return c.value ? 1 : 0;
+					}
+					auto operator()(const tac::Label& label) -> std::uint64_t
+					{
+						return writer.label(label);
+					}
+					auto operator()(const tac::CallArgNum& num) -> std::uint64_t
+					{
+						return num.size;
+					}
+				};
+				if(auto var = std::get_if<SymbolTable::Variable*>(&address); var != nullptr && (*var)->isTemp)
+				{
+					auto iter = temporaryIndex.find(*var);
+					if(iter == temporaryIndex.end())
+					{
+						throw std::runtime_error("Temporary of another function");
+					}
+					return {temporaryTag, iter->second};
+				}
+				return {static_cast<std::uint8_t>(address.index()), std::visit(Encoder{*this}, address)};
+			}
+
+			void tacCode(const std::vector<tac::Function>& tacFunctions)
+			{
+				for(auto& function : tacFunctions)
+				{
+					this->tacFunctions.push_back({
+						symbol(function.sym_entry),
+						static_cast<std::uint32_t>(quadruples.size()),
+						static_cast<std::uint32_t>(function.tac.size()),
+						static_cast<std::uint32_t>(temporaries.size()),
+						static_cast<std::uint32_t>(function.temporaries.size()),
+					});
+					temporaryIndex.clear();
+					for(auto& temp : function.temporaries)
+					{
+						temporaryIndex.emplace(temp.get(), static_cast<std::uint32_t>(temporaryIndex.size()));
+						temporaries.push_back({temp->id, static_cast<std::uint8_t>(temp->type)});
+					}
+					for(auto& quad : function.tac)
+					{
+						quadruples.push_back({
+							quad.label.empty() ? noIndex : label(quad.label),
+							static_cast<std::uint8_t>(quad.instr),
+							operand(quad.result),
+							operand(quad.arg1),
+							operand(quad.arg2),
+						});
+					}
+				}
+			}
+		};
+
+		template<typename T>
+		void append(std::vector<char>& out, SectionRecord& record, const std::vector<T>& values)
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "Records are stored bytewise");
+			out.resize((out.size() + sectionAlignment - 1) / sectionAlignment * sectionAlignment);
+			record = {out.size(), values.size() * sizeof(T)};
+			auto bytes = reinterpret_cast<const char*>(values.data());
+			out.insert(out.end(), bytes, bytes + record.size);
+		}
+	}
+
+	std::uint64_t hashSource(std::string_view program)
+	{
+		// FNV-1a
+		std::uint64_t hash = 14695981039346656037ull;
+		for(unsigned char c : program)
+		{
+			hash = (hash ^ c) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	void write(const std::string& path, std::uint64_t sourceHash, ast::Program& program, const std::vector<tac::Function>& functions)
+	{
+		Writer writer;
+		for(SymbolId id = 0; id < program.names->size(); ++id)
+		{
+			writer.names.push_back(writer.string(program.names->name(id)));
+		}
+		writer.symbolTables(*program.root);
+		auto flat = ast::flatten(program);
+		writer.flatAst(flat);
+		writer.tacCode(functions);
+
+		Header header{};
+		std::copy(std::begin(magic), std::end(magic), header.magic);
+		header.version = version;
+		header.sectionCount = sectionCount;
+		header.sourceHash = sourceHash;
+
+		std::vector<char> out(sizeof(Header));
+		auto section = [&](Section which, auto& values)
+		{
+			append(out, header.sections[static_cast<std::size_t>(which)], values);
+		};
+		section(Section::Chars, writer.chars);
+		section(Section::Names, writer.names);
+		section(Section::Scopes, writer.scopes);
+		section(Section::Symbols, writer.symbols);
+		section(Section::Parameters, writer.parameters);
+		section(Section::Nodes, flat.nodes);
+		section(Section::Lists, flat.lists);
+		section(Section::Variables, writer.variables);
+		section(Section::Functions, writer.functions);
+		section(Section::Floats, flat.floats);
+		section(Section::Strings, writer.strings);
+		section(Section::Bodies, writer.bodies);
+		section(Section::Labels, writer.labels);
+		section(Section::Quadruples, writer.quadruples);
+		section(Section::TacFunctions, writer.tacFunctions);
+		section(Section::Temporaries, writer.temporaries);
+		auto headerBytes = reinterpret_cast<const char*>(&header);
+		std::copy(headerBytes, headerBytes + sizeof(Header), out.begin());
+
+		// Written aside and renamed, so a reader never maps a half written file
+		auto temporary = path + ".tmp";
+		{
+			std::ofstream file{temporary, std::ios::binary | std::ios::trunc};
+			file.write(out.data(), static_cast<std::streamsize>(out.size()));
+			if(!file)
+			{
+				throw std::runtime_error("Cannot write " + temporary);
+			}
+		}
+		std::filesystem::rename(temporary, path);
+	}
+
+	CacheFile::CacheFile(const std::string& path):
+		file{path}
+	{
+		auto bytes = file.view();
+		if(bytes.size() < sizeof(Header) || !std::equal(std::begin(magic), std::end(magic), header().magic))
+		{
+			throw std::runtime_error("Not a cache file: " + path);
+		}
+		if(header().version != version || header().sectionCount != sectionCount)
+		{
+			throw std::runtime_error("Cache file of another version: " + path);
+		}
+		for(auto& record : header().sections)
+		{
+			if(record.offset % sectionAlignment != 0 || record.offset > bytes.size() || record.size > bytes.size() - record.offset)
+			{
+				damaged();
+			}
+		}
+	}
+
+	auto CacheFile::load(Interner& names) const -> Compilation
+	{
+		// Ids in names may differ from the ones the cache was written with
+		std::vector<SymbolId> ids;
+		for(auto& record : section<StringRecord>(Section::Names))
+		{
+			ids.push_back(names.intern(string(record)));
+		}
+
+		auto scopeRecords = section<ScopeRecord>(Section::Scopes);
+		auto symbolRecords = section<SymbolRecord>(Section::Symbols);
+		if(scopeRecords.empty() || scopeRecords[0].parent != noIndex)
+		{
+			damaged();
+		}
+
+		// Preorder, so parents come before their children and children in order
+		auto root = std::make_unique<SymbolTable>();
+		std::vector<SymbolTable*> scopes;
+		for(auto& record : scopeRecords)
+		{
+			if(scopes.empty())
+			{
+				scopes.push_back(root.get());
+			}
+			else if(record.parent < scopes.size())
+			{
+				scopes.push_back(&scopes[record.parent]->addChild(std::make_unique<SymbolTable>()));
+			}
+			else
+			{
+				damaged();
+			}
+		}
+
+		auto type = [](std::uint8_t value)
+		{
+			if(value > SymbolTable::Variable::Type::Bool)
+			{
+				damaged();
+			}
+			return static_cast<SymbolTable::Variable::Type>(value);
+		};
+
+		std::vector<SymbolTable::Symbol*> symbols(symbolRecords.size(), nullptr);
+		for(std::size_t i = 0; i < scopeRecords.size(); ++i)
+		{
+			auto& scope = scopeRecords[i];
+			for(auto s = scope.firstSymbol; s < std::uint64_t{scope.firstSymbol} + scope.symbolCount; ++s)
+			{
+				auto& record = at(symbolRecords, s);
+				auto id = at(std::span<const SymbolId>{ids}, record.name);
+				if(record.kind == SymbolRecord::Variable)
+				{
+					symbols[s] = &scopes[i]->insert(id, SymbolTable::Symbol{SymbolTable::Variable{id, names.name(id), type(record.type)}});
+				}
+				else if(record.kind == SymbolRecord::Function)
+				{
+					auto parameterScope = record.scope == noIndex ? nullptr : at(std::span<SymbolTable* const>{scopes}, record.scope);
+					symbols[s] = &scopes[i]->insert(id, SymbolTable::Symbol{SymbolTable::Function{id, names.name(id), type(record.type), parameterScope}});
+				}
+				else
+				{
+					damaged();
+				}
+			}
+		}
+
+		auto symbol = [&]<typename T>(std::uint64_t index) -> T*
+		{
+			auto entry = at(std::span<SymbolTable::Symbol* const>{symbols}, index);
+			auto ptr = entry ? std::get_if<T>(entry) : nullptr;
+			if(ptr == nullptr)
+			{
+				damaged();
+			}
+			return ptr;
+		};
+		auto variable = [&](std::uint64_t index)
+		{
+			return symbol.template operator()<SymbolTable::Variable>(index);
+		};
+		auto function = [&](std::uint64_t index)
+		{
+			return symbol.template operator()<SymbolTable::Function>(index);
+		};
+
+		auto parameters = section<std::uint32_t>(Section::Parameters);
+		for(std::size_t s = 0; s < symbolRecords.size(); ++s)
+		{
+			auto& record = symbolRecords[s];
+			if(record.kind != SymbolRecord::Function)
+			{
+				continue;
+			}
+			auto func = function(s);
+			for(auto p = record.firstParameter; p < std::uint64_t{record.firstParameter} + record.parameterCount; ++p)
+			{
+				func->parameters.push_back(variable(at(parameters, p)));
+			}
+		}
+
+		// Children are stored before their parents, so one pass front to back rebuilds the tree
+		Arena arena;
+		auto nodes = section<ast::Node>(Section::Nodes);
+		auto lists = section<ast::NodeId>(Section::Lists);
+		auto variables = section<std::uint32_t>(Section::Variables);
+		auto functions = section<std::uint32_t>(Section::Functions);
+		auto floats = section<double>(Section::Floats);
+		auto strings = section<StringRecord>(Section::Strings);
+		std::vector<ast::Expression*> expressions(nodes.size(), nullptr);
+		std::vector<ast::Statement*> statements(nodes.size(), nullptr);
+		std::vector<ast::Expression*> arguments;
+		std::vector<ast::Statement*> children;
+
+		for(std::size_t i = 0; i < nodes.size(); ++i)
+		{
+			auto& node = nodes[i];
+			auto expr = [&](ast::NodeId id)
+			{
+				if(id >= i || expressions[id] == nullptr)
+				{
+					damaged();
+				}
+				return expressions[id];
+			};
+			auto stmt = [&](ast::NodeId id) -> ast::Statement*
+			{
+				if(id >= i || statements[id] == nullptr)
+				{
+					damaged();
+				}
+				return statements[id];
+			};
+			auto list = [&](const ast::Node& node)
+			{
+				if(node.b > lists.size() || node.c > lists.size() - node.b)
+				{
+					damaged();
+				}
+				return lists.subspan(node.b, node.c);
+			};
+
+			switch(node.kind)
+			{
+				case ast::NodeKind::Binary:
+					expressions[i] = arena.make<ast::BinaryExpression>(expr(node.a), expr(node.b), static_cast<ast::BinaryOperator>(node.op));
+					break;
+				case ast::NodeKind::Unary:
+					expressions[i] = arena.make<ast::UnaryExpression>(expr(node.a), static_cast<ast::UnaryOperator>(node.op));
+					break;
+				case ast::NodeKind::Variable:
+					expressions[i] = arena.make<ast::Variable>(variable(at(variables, node.a)));
+					break;
+				case ast::NodeKind::Call:
+				{
+					arguments.clear();
+					for(auto arg : list(node))
+					{
+						arguments.push_back(expr(arg));
+					}
+					expressions[i] = arena.make<ast::Call>(function(at(functions, node.a)), arena.copy(std::span<ast::Expression* const>{arguments}));
+					break;
+				}
+				case ast::NodeKind::IntConst:
+					expressions[i] = arena.make<ast::Constant<int>>(static_cast<int>(node.a));
+					break;
+				case ast::NodeKind::FloatConst:
+					expressions[i] = arena.make<ast::Constant<double>>(at(floats, node.a));
+					break;
+				case ast::NodeKind::BoolConst:
+					expressions[i] = arena.make<ast::Constant<bool>>(node.a != 0);
+					break;
+				case ast::NodeKind::StrConst:
+					expressions[i] = arena.make<ast::Constant<std::string_view>>(arena.copy(string(at(strings, node.a))));
+					break;
+				case ast::NodeKind::ExprStmt:
+					statements[i] = arena.make<ast::ExprStmt>(expr(node.a));
+					break;
+				case ast::NodeKind::If:
+					statements[i] = arena.make<ast::IfStmt>(expr(node.a), stmt(node.b), node.c == ast::noNode ? nullptr : stmt(node.c));
+					break;
+				case ast::NodeKind::While:
+					statements[i] = arena.make<ast::WhileStmt>(expr(node.a), stmt(node.b));
+					break;
+				case ast::NodeKind::Return:
+					statements[i] = arena.make<ast::ReturnStmt>(node.a == ast::noNode ? nullptr : expr(node.a));
+					break;
+				case ast::NodeKind::Block:
+				{
+					children.clear();
+					for(auto child : list(node))
+					{
+						children.push_back(stmt(child));
+					}
+					statements[i] = arena.make<ast::Block>(arena.copy(std::span<ast::Statement* const>{children}));
+					break;
+				}
+				default:
+					damaged();
+			}
+		}
+
+		std::vector<ast::Function> bodies;
+		for(auto& record : section<BodyRecord>(Section::Bodies))
+		{
+			auto body = at(std::span<ast::Statement* const>{statements}, record.body);
+			if(body == nullptr || body->kind != ast::StmtKind::Block)
+			{
+				damaged();
+			}
+			bodies.push_back({function(record.function), static_cast<ast::Block*>(body)});
+		}
+
+		auto labels = section<StringRecord>(Section::Labels);
+		tac::Function* current = nullptr;
+		auto operand = [&](const OperandRecord& record) -> tac::Address
+		{
+			if(record.tag == temporaryTag)
+			{
+				if(record.value >= current->temporaries.size())
+				{
+					damaged();
+				}
+				return current->temporaries[record.value].get();
+			}
+			switch(record.tag)
+			{
+				case 0:
+					return std::monostate{};
+				case 1:
+					return variable(record.value);
+				case 2:
+					return function(record.value);
+				case 3:
+					return tac::Constant<int>{static_cast<int>(static_cast<std::int64_t>(record.value))};
+				case 4:
+					return tac::Constant<double>{std::bit_cast<double>(record.value)};
+				case 5:
+					return tac::Constant<bool>{record.value != 0};
+				case 6:
+					return tac::Label{string(at(labels, record.value))};
+				case 7:
+					return tac::CallArgNum{static_cast<std::size_t>(record.value)};
+				default:
+					damaged();
+			}
+		};
+
+		auto quadruples = section<QuadrupleRecord>(Section::Quadruples);
+		auto temporaries = section<TemporaryRecord>(Section::Temporaries);
+		std::vector<tac::Function> tacFunctions;
+		for(auto& record : section<TacFunctionRecord>(Section::TacFunctions))
+		{
+			tac::Function tacFunction{function(record.function)};
+			for(auto t = record.firstTemporary; t < std::uint64_t{record.firstTemporary} + record.temporaryCount; ++t)
+			{
+				auto& temp = at(temporaries, t);
+				auto& var = tacFunction.temporaries.emplace_back(std::make_unique<SymbolTable::Variable>(SymbolTable::Variable{temp.number, {}, type(temp.type)}));
+				var->isTemp = true;
+			}
+			current = &tacFunction;
+			for(auto q = record.firstQuadruple; q < std::uint64_t{record.firstQuadruple} + record.quadrupleCount; ++q)
+			{
+				auto& quad = at(quadruples, q);
+				if(quad.instr > static_cast<std::uint8_t>(tac::InstructionType::Or))
+				{
+					damaged();
+				}
+				tacFunction.tac.push_back({
+					quad.label == noIndex ? tac::Label{} : tac::Label{string(at(labels, quad.label))},
+					static_cast<tac::InstructionType>(quad.instr),
+					operand(quad.result),
+					operand(quad.arg1),
+					operand(quad.arg2),
+				});
+			}
+			tac::numberVariables(tacFunction);
+			tacFunctions.push_back(std::move(tacFunction));
+		}
+
+		return {ast::Program{std::move(root), std::move(bodies), &names, std::move(arena)}, std::move(tacFunctions)};
+	}
+}
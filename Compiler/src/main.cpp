@@ -1,20 +1,31 @@
 #include "Ast/Ast.hpp"
 #include "Parser/Parser.hpp"
 #include "Lexer/Lexer.hpp"
+#include "Lexer/SourceFile.hpp"
+#include "Lexer/StreamingLexer.hpp"
+#include "Lexer/LineIndex.hpp"
 #include <string>
+#include <string_view>
+#include <optional>
 #include <vector>
 #include <iostream>
+#include <cstdlib>
+#include <cstdint>
+#include <exception>
 #include "Token/Token.hpp"
+#include "Token/TokenBuffer.hpp"
+#include "Token/CompileError.hpp"
 #include "TacGenerator/TacGenerator.hpp"
 #include "AsmGenerator/AsmGenerator.hpp"
+#include "Cache/Cache.hpp"
 
 
 
 
 
-int main()
+int main(int argc, char** argv)
 {
-	std::string program = R"(
+	std::string example = R"(
 	
 	bool main()
 	{
@@ -30,31 +41,138 @@ int main()
 	}
 )";
 
+	// "-" streams the program from stdin, a path compiles that file in place,
+	// otherwise fall back to the example program
+	std::optional<Lexer::SourceFile> source;
+	std::string_view program = example;
+	bool streaming = argc > 1 && std::string_view{argv[1]} == "-";
+	if(argc > 1 && !streaming)
+	{
+		try
+		{
+			source.emplace(argv[1]);
+		}
+		catch(const std::exception& e)
+		{
+			std::cerr << argv[1] << ": error: " << e.what() << '\n';
+			return EXIT_FAILURE;
+		}
+		program = source->view();
+	}
 
-	std::cout << program << '\n';
+	intermediate_rep::Interner names;
 
+	auto parse = [&]()
 	{
-		Lexer::Lexer lexer{program};
-		auto t = lexer.next();
-		while( t.type != intermediate_rep::Token::Type::Eof)
+		if(streaming)
 		{
-			std::cout << t << ", ";
-			t = lexer.next();
+			Lexer::StreamingLexer lexer{std::cin, names};
+			Parser::Parser parser{&lexer};
+			return parser.program();
 		}
-		std::cout << '\n';
-	}
 
-	Lexer::Lexer lexer{program};
+		std::cout << program << '\n';
+
+		{
+			Lexer::Lexer lexer{program, names};
+			auto t = lexer.next();
+			while( t.type != intermediate_rep::Token::Type::Eof)
+			{
+				intermediate_rep::print(std::cout, t, lexer.text(t)) << ", ";
+				t = lexer.next();
+			}
+			std::cout << '\n';
+		}
+
+		intermediate_rep::TokenBuffer tokens;
+		Lexer::tokenizeParallel(program, tokens, names);
+
+		Parser::Parser parser{tokens};
 
-	Parser::Parser parser{&lexer};
+		return parser.programParallel();
+	};
+
+	// A file compiled before is restored from the cache next to it, as long as it did not change
+	std::optional<cache::Compilation> cached;
+	std::string cachePath;
+	std::uint64_t sourceHash = 0;
+	if(source)
+	{
+		cachePath = std::string{argv[1]} + ".cache";
+		sourceHash = cache::hashSource(program);
+		try
+		{
+			cache::CacheFile file{cachePath};
+			if(file.sourceHash() == sourceHash)
+			{
+				cached.emplace(file.load(names));
+			}
+		}
+		catch(const std::exception&)
+		{
+			// Missing, of another version or damaged, compile from scratch
+		}
+	}
 
-	auto ast = parser.program();
+	std::optional<intermediate_rep::ast::Program> parsed;
+	std::vector<intermediate_rep::tac::Function> tac;
+	if(cached)
+	{
+		parsed.emplace(std::move(cached->program));
+		tac = std::move(cached->functions);
+	}
+	else
+	{
+		try
+		{
+			parsed.emplace(parse());
+		}
+		catch(const intermediate_rep::CompileError& e)
+		{
+			// Streamed programs are gone by now, only the offset is left
+			if(streaming)
+			{
+				std::cerr << "<stdin>:" << e.offset() << ": error: " << e.what() << '\n';
+			}
+			else
+			{
+				auto [line, column] = Lexer::LineIndex{program}.locate(e.offset());
+				std::cerr << (source ? argv[1] : "<example>") << ':' << line << ':' << column << ": error: " << e.what() << '\n';
+			}
+			return EXIT_FAILURE;
+		}
+	}
+	auto& ast = *parsed;
 
 	std::cout << ast << '\n';
 
-	tac_gen::TacGenerator tacGen{&ast};
+	if(!cached)
+	{
+		tac_gen::TacGenerator tacGen{&ast};
 
-	auto tac = tacGen.gen();
+		try
+		{
+			tac = tacGen.gen();
+		}
+		catch(const std::exception& e)
+		{
+			// Constructs the parser accepts but the later stages do not support yet
+			std::cerr << (source ? argv[1] : streaming ? "<stdin>" : "<example>") << ": error: " << e.what() << '\n';
+			return EXIT_FAILURE;
+		}
+
+		if(source)
+		{
+			try
+			{
+				cache::write(cachePath, sourceHash, ast, tac);
+			}
+			catch(const std::exception& e)
+			{
+				std::cerr << "warning: " << e.what() << '\n';
+			}
+		}
+	}
 
 	for(auto& function : tac)
 	{
@@ -70,7 +188,7 @@ int main()
 	std::cout << basicBlocks << '\n';
 
 
-	auto live = assemblyGen.nextUseLive(basicBlocks[0], tac[0].sym_entry->parameter_scope->getChild(0));
+	auto live = assemblyGen.nextUseLive(basicBlocks[0]);
 
 	printLiveNessRanges(std::cout, basicBlocks[0], live);
 
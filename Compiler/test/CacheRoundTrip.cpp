@@ -0,0 +1,97 @@
+#include "Ast/Ast.hpp"
+#include "Cache/Cache.hpp"
+#include "Lexer/Lexer.hpp"
+#include "Parser/Parser.hpp"
+#include "TacGenerator/TacGenerator.hpp"
+#include "AsmGenerator/AsmGenerator.hpp"
+#include "Token/TokenBuffer.hpp"
+#include "Check.hpp"
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A program loaded from its cache prints the same AST, TAC and assembly as the program that was written.
+
+namespace
+{
+	using namespace intermediate_rep;
+	using test::check;
+
+	constexpr std::string_view program = R"(
+int f(int a, int b)
+{
+	return a * b - (a + b);
+}
+
+bool g(bool x)
+{
+	return not x;
+}
+
+int main()
+{
+	int x = 1;
+	float y = 2.5;
+	if(x < 3 and g(true))
+	{
+		x = f(x, -x) + f(3, 4);
+	}
+	else
+	{
+		y = y * 0.5;
+	}
+	while(x > 0)
+	{
+		x = x - 1;
+	}
+	return x;
+}
+)";
+
+	std::string listing(const ast::Program& ast, std::vector<tac::Function>& functions)
+	{
+		std::ostringstream os;
+		os << ast;
+		for(auto& function : functions)
+		{
+			os << function;
+		}
+		assembly::AsmGenerator{functions, os}.gen();
+		return os.str();
+	}
+}
+
+int main()
+{
+	auto path = (std::filesystem::temp_directory_path() / "cache_round_trip.cache").string();
+	auto hash = cache::hashSource(program);
+
+	Interner names;
+	TokenBuffer tokens;
+	Lexer::Lexer{program, names}.tokenizeAll(tokens);
+	Parser::Parser parser{tokens};
+	auto ast = parser.program();
+	auto functions = tac_gen::TacGenerator{&ast}.gen();
+	cache::write(path, hash, ast, functions);
+	auto expected = listing(ast, functions);
+
+	try
+	{
+		// Loaded into names of its own, as a later run of the compiler would
+		Interner loadedNames;
+		cache::CacheFile file{path};
+		check(file.sourceHash() == hash, "hash of the source");
+		auto loaded = file.load(loadedNames);
+		check(listing(loaded.program, loaded.functions) == expected, "program loaded from the cache");
+	}
+	catch(const std::exception& e)
+	{
+		check(false, std::string{"loading the cache: "} + e.what());
+	}
+	std::filesystem::remove(path);
+	return test::failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
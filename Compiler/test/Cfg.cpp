@@ -0,0 +1,118 @@
+#include "Ast/Ast.hpp"
+#include "Lexer/Lexer.hpp"
+#include "Parser/Parser.hpp"
+#include "TacGenerator/TacGenerator.hpp"
+#include "Tac/Cfg.hpp"
+#include "Token/TokenBuffer.hpp"
+#include "Check.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+// Jumps resolve to the block that starts at their label, also when a call follows an if or else
+// and its parameters are passed before the call itself.
+
+namespace
+{
+	using namespace intermediate_rep;
+
+	constexpr std::string_view program = R"(
+int f(int a, int b)
+{
+	return a + b;
+}
+
+int main()
+{
+	int x = 1;
+	if(x < 2)
+	{
+		x = 3;
+	}
+	else
+	{
+		f(3, x);
+	}
+	f(x, x);
+	while(x < 5)
+	{
+		x = x + 1;
+	}
+	return x;
+}
+)";
+
+	using test::check;
+
+	// Index of the first quadruple that carries label
+	std::uint32_t definition(const tac::Function& function, std::string_view label)
+	{
+		auto iter = std::find_if(function.tac.begin(), function.tac.end(), [&](auto& quad){ return quad.label == label; });
+		return static_cast<std::uint32_t>(iter - function.tac.begin());
+	}
+
+	// Every jump leads to the first quadruple with its label, every call is reachable
+	void checkJumps(tac::Function& function, std::string_view what)
+	{
+		tac::Cfg cfg{function};
+		auto reachable = cfg.postorder();
+		for(auto id : cfg.layout())
+		{
+			auto code = cfg.code(id);
+			auto& last = code.back();
+			if(auto label = std::get_if<tac::Label>(&last.result); label != nullptr && last.instr != tac::InstructionType::Call)
+			{
+				auto target = cfg.blockOf(*label);
+				check(target != cfg.noBlock && cfg.block(target).begin == definition(function, *label),
+					std::string{what} + ": jump to " + *label + " misses its first definition");
+			}
+			auto hasParam = std::any_of(code.begin(), code.end(), [](auto& quad){ return quad.instr == tac::InstructionType::Param; });
+			if(hasParam)
+			{
+				check(std::find(reachable.begin(), reachable.end(), id) != reachable.end(),
+					std::string{what} + ": parameters of a call are unreachable");
+			}
+		}
+	}
+}
+
+int main()
+{
+	Interner names;
+	TokenBuffer tokens;
+	Lexer::Lexer{program, names}.tokenizeAll(tokens);
+	Parser::Parser parser{tokens};
+	auto ast = parser.program();
+	auto functions = tac_gen::TacGenerator{&ast}.gen();
+
+	for(auto& function : functions)
+	{
+		// The generator places every label once
+		std::vector<std::string_view> labels;
+		for(auto& quad : function.tac)
+		{
+			if(!quad.label.empty())
+			{
+				check(std::find(labels.begin(), labels.end(), quad.label) == labels.end(), "label " + quad.label + " placed twice");
+				labels.push_back(quad.label);
+			}
+		}
+		checkJumps(function, "generated code");
+
+		// A label repeated on the following quadruples still resolves to where it starts
+		for(std::size_t i = 0; i + 1 < function.tac.size(); ++i)
+		{
+			if(!function.tac[i].label.empty() && function.tac[i + 1].label.empty())
+			{
+				function.tac[i + 1].label = function.tac[i].label;
+				++i;
+			}
+		}
+		checkJumps(function, "repeated labels");
+	}
+	return test::failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,65 @@
+#ifndef check_hpp
+#define check_hpp
+#include "Token/Token.hpp"
+#include "Token/TokenBuffer.hpp"
+#include <cstddef>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+// Helpers shared by the tests of the compiler. A test reports every failed check and
+// returns EXIT_FAILURE from main if there was one.
+
+namespace test
+{
+	inline int failures = 0;
+
+	inline void check(bool ok, std::string_view what)
+	{
+		if(!ok)
+		{
+			std::cerr << "FAILED: " << what << '\n';
+			++failures;
+		}
+	}
+
+	// One line per token with type, offset, text and decoded value, so tokens of different
+	// lexers and interners compare as strings
+	inline void describe(std::ostream& os, const intermediate_rep::Token& token, std::string_view text)
+	{
+		using intermediate_rep::Token;
+		os << intermediate_rep::tokenTypeToStr(token.type) << ' ' << token.offset << ' ' << text;
+		if(token.type == Token::IntLit)
+		{
+			os << ' ' << token.intValue;
+		}
+		else if(token.type == Token::FloatLit)
+		{
+			os << ' ' << token.floatValue;
+		}
+		os << '\n';
+	}
+
+	inline std::string describe(const intermediate_rep::TokenBuffer& tokens)
+	{
+		std::ostringstream os;
+		for(std::size_t i = 0; i < tokens.size(); ++i)
+		{
+			auto token = tokens[i];
+			describe(os, token, intermediate_rep::lexem(token, tokens.source, *tokens.names));
+		}
+		return os.str();
+	}
+
+	// Output of os << value
+	template<typename T>
+	std::string print(const T& value)
+	{
+		std::ostringstream os;
+		os << value;
+		return os.str();
+	}
+}
+
+#endif
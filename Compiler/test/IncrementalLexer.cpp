@@ -0,0 +1,93 @@
+#include "Lexer/IncrementalLexer.hpp"
+#include "Lexer/Lexer.hpp"
+#include "Token/CompileError.hpp"
+#include "Token/TokenBuffer.hpp"
+#include "Check.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <string_view>
+
+// After every edit the tokens of an IncrementalLexer are the ones a full lex of the edited program gives.
+
+namespace
+{
+	using namespace intermediate_rep;
+	using test::check;
+
+	constexpr std::string_view program = R"(int f(int a, float b)
+{
+	return a * 2 + 10;
+}
+
+bool main()
+{
+	float x = 1.5;
+	str s = "a string literal";
+	while(x <= 100.25 and not false)
+	{
+		x = x * 2.0;
+	}
+	return f(3, x) >= 42;
+}
+)";
+
+	// Pieces that are inserted or replace text, some of them merge with their neighbours
+	constexpr std::array<std::string_view, 14> pieces
+	{
+		"", " ", "\n", "x", "abc", "1", "2.5", "=", "<", ">=", "\"", "\"text\"", "and", "// "
+	};
+
+	std::string fullLex(std::string_view text)
+	{
+		Interner names;
+		TokenBuffer tokens;
+		Lexer::Lexer{text, names}.tokenizeAll(tokens);
+		return test::describe(tokens);
+	}
+}
+
+int main()
+{
+	Interner names;
+	Lexer::IncrementalLexer lexer{std::string{program}, names};
+	check(test::describe(lexer.tokens()) == fullLex(lexer.program()), "tokens before any edit");
+
+	std::mt19937 random{2024};
+	for(int i = 0; i < 3000; ++i)
+	{
+		auto size = lexer.program().size();
+		auto begin = std::uniform_int_distribution<std::size_t>{0, size}(random);
+		auto end = std::min(size, begin + std::uniform_int_distribution<std::size_t>{0, 6}(random));
+		auto piece = pieces[std::uniform_int_distribution<std::size_t>{0, pieces.size() - 1}(random)];
+
+		std::string expected{lexer.program()};
+		expected.replace(begin, end - begin, piece);
+		try
+		{
+			lexer.edit(begin, end, piece);
+			check(lexer.program() == expected, "program after edit " + std::to_string(i));
+		}
+		catch(const CompileError&)
+		{
+			// A failed edit leaves the program as it was, a full lex fails the same way
+			try
+			{
+				fullLex(expected);
+				check(false, "edit " + std::to_string(i) + " failed, lexing the edited program did not");
+			}
+			catch(const CompileError&)
+			{
+			}
+		}
+		check(test::describe(lexer.tokens()) == fullLex(lexer.program()), "tokens after edit " + std::to_string(i));
+		if(test::failures != 0)
+		{
+			break;
+		}
+	}
+	return test::failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,82 @@
+#include "Ast/Ast.hpp"
+#include "Lexer/Lexer.hpp"
+#include "Parser/Parser.hpp"
+#include "TacGenerator/TacGenerator.hpp"
+#include "AsmGenerator/AsmGenerator.hpp"
+#include "Token/CompileError.hpp"
+#include "Token/TokenBuffer.hpp"
+#include "Check.hpp"
+#include <cstddef>
+#include <cstdlib>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// Programs nested up to Parser::defaultMaxNesting go through the whole pipeline,
+// deeper ones are rejected with a CompileError instead of overflowing the stack.
+
+namespace
+{
+	using namespace intermediate_rep;
+
+	constexpr std::size_t limit = Parser::Parser<TokenBufferReader>::defaultMaxNesting;
+
+	// depth levels of blocks or parentheses inside the body of main
+	std::string nested(std::size_t depth, bool parentheses)
+	{
+		std::string program = "int main()\n{\n";
+		if(parentheses)
+		{
+			program += "int a = " + std::string(depth, '(') + "1" + std::string(depth, ')') + ";\n";
+		}
+		else
+		{
+			program += std::string(depth, '{') + std::string(depth, '}') + "\n";
+		}
+		return program + "return 0;\n}\n";
+	}
+
+	void compile(std::string_view program)
+	{
+		Interner names;
+		TokenBuffer tokens;
+		Lexer::Lexer{program, names}.tokenizeAll(tokens);
+		Parser::Parser parser{tokens};
+		auto ast = parser.programParallel();
+
+		std::ostream discard{nullptr};
+		discard << ast;
+		auto tac = tac_gen::TacGenerator{&ast}.gen();
+		assembly::AsmGenerator{tac, discard}.gen();
+	}
+
+	using test::check;
+}
+
+int main()
+{
+	for(bool parentheses : {false, true})
+	{
+		std::string_view kind = parentheses ? "parentheses" : "blocks";
+
+		try
+		{
+			compile(nested(limit - 2, parentheses));
+		}
+		catch(const std::exception& e)
+		{
+			check(false, std::string{kind} + " at the limit: " + e.what());
+		}
+
+		try
+		{
+			compile(nested(limit, parentheses));
+			check(false, std::string{kind} + " over the limit compiled");
+		}
+		catch(const CompileError& e)
+		{
+			check(std::string_view{e.what()}.starts_with("Nesting deeper than"), std::string{kind} + " over the limit: " + e.what());
+		}
+	}
+	return test::failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
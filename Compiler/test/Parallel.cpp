@@ -0,0 +1,70 @@
+#include "Ast/Ast.hpp"
+#include "Lexer/Lexer.hpp"
+#include "Parser/Parser.hpp"
+#include "Token/TokenBuffer.hpp"
+#include "Check.hpp"
+#include <cstddef>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+// tokenizeParallel and programParallel give the tokens and AST of the sequential lexer and parser.
+// The program is large enough to be split into several pieces for each thread count.
+
+namespace
+{
+	using namespace intermediate_rep;
+	using test::check;
+
+	std::string generate(std::size_t functions)
+	{
+		std::ostringstream os;
+		for(std::size_t i = 0; i < functions; ++i)
+		{
+			os << "int f" << i << "(int a, int b)\n{\n"
+				<< "\tint c = a * " << i << " + b;\n"
+				<< "\tfloat d = 1.5 * " << i << ".25;\n"
+				<< "\tif(c > " << i << " and d < 2.0)\n\t{\n"
+				<< "\t\tc = " << (i == 0 ? std::string{"c + a"} : "f" + std::to_string(i - 1) + "(c, a)") << " - 1;\n"
+				<< "\t}\n\telse\n\t{\n\t\tc = c - 1;\n\t}\n"
+				<< "\twhile(c < 10)\n\t{\n\t\tc = c + 2;\n\t}\n"
+				<< "\treturn c;\n}\n\n";
+		}
+		os << "int main()\n{\n\treturn f" << functions - 1 << "(1, 2);\n}\n";
+		return os.str();
+	}
+
+	// Listing of the AST of the program in tokens, parsed sequentially for threads = 0
+	std::string parse(const TokenBuffer& tokens, unsigned threads)
+	{
+		Parser::Parser parser{tokens};
+		return test::print(threads == 0 ? parser.program() : parser.programParallel(threads));
+	}
+}
+
+int main()
+{
+	auto program = generate(3000);
+
+	Interner names;
+	TokenBuffer sequential;
+	Lexer::Lexer{program, names}.tokenizeAll(sequential);
+	auto expected = parse(sequential, 0);
+
+	for(unsigned threads = 1; threads <= 4; ++threads)
+	{
+		auto what = std::to_string(threads) + " threads";
+
+		// Same symbol ids and literal indices, not only the same text
+		Interner parallelNames;
+		TokenBuffer tokens;
+		Lexer::tokenizeParallel(program, tokens, parallelNames, threads);
+		check(tokens.types == sequential.types && tokens.offsets == sequential.offsets
+			&& tokens.lengths == sequential.lengths && tokens.literals == sequential.literals, "tokens on " + what);
+		check(test::describe(tokens) == test::describe(sequential), "token text on " + what);
+
+		check(parse(sequential, threads) == expected, "AST on " + what);
+	}
+	return test::failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
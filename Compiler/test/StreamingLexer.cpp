@@ -0,0 +1,69 @@
+#include "Lexer/StreamingLexer.hpp"
+#include "Lexer/Lexer.hpp"
+#include "Token/TokenBuffer.hpp"
+#include "Check.hpp"
+#include <cstddef>
+#include <cstdlib>
+#include <initializer_list>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+// Streaming a program in chunks gives the tokens of lexing it in one piece, wherever the chunks are cut.
+// The strings hold spaces and are longer than the small chunks, so cuts fall inside them.
+
+namespace
+{
+	using namespace intermediate_rep;
+	using test::check;
+
+	constexpr std::string_view program = R"(int f(int a, int b)
+{
+	return a * 12345 - b;
+}
+
+bool main()
+{
+	str s = "a string with spaces, longer than a chunk";
+	float averyveryverylongidentifier = 3.25 + 100.5;
+	if(f(1, 2) <= 7 and not false)
+	{
+		s = "  leading and trailing spaces  ";
+	}
+	return s == "" or averyveryverylongidentifier >= 0.5;
+})";
+
+	std::string streamed(std::size_t chunkSize)
+	{
+		Interner names;
+		std::istringstream stream{std::string{program}};
+		Lexer::StreamingLexer lexer{stream, names, chunkSize};
+		std::ostringstream os;
+		Token token;
+		do
+		{
+			token = lexer.next();
+			test::describe(os, token, lexer.text(token));
+		}
+		while(token.type != Token::Eof);
+		return os.str();
+	}
+}
+
+int main()
+{
+	Interner names;
+	TokenBuffer tokens;
+	Lexer::Lexer{program, names}.tokenizeAll(tokens);
+	auto expected = test::describe(tokens);
+
+	for(std::size_t chunkSize = 1; chunkSize <= 48; ++chunkSize)
+	{
+		check(streamed(chunkSize) == expected, "chunks of " + std::to_string(chunkSize) + " bytes");
+	}
+	for(std::size_t chunkSize : {program.size() - 1, program.size(), Lexer::StreamingLexer::defaultChunkSize})
+	{
+		check(streamed(chunkSize) == expected, "chunks of " + std::to_string(chunkSize) + " bytes");
+	}
+	return test::failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
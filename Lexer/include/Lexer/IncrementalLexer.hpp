@@ -0,0 +1,50 @@
+#ifndef incrementallexer_hpp
+#define incrementallexer_hpp
+#include "Token/Token.hpp"
+#include "Token/TokenBuffer.hpp"
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+namespace Lexer
+{
+	// Tokens [begin, oldEnd) before an edit were replaced by tokens [begin, newEnd) after it.
+	// Tokens from newEnd on are the old ones, only their offsets moved by the size change of the edit.
+	struct TokenChange
+	{
+		std::size_t begin;
+		std::size_t oldEnd;
+		std::size_t newEnd;
+	};
+
+	// Owns a program and its tokens and keeps both up to date while the program is edited.
+	// An edit relexes from the last token starting before the edited bytes until the new
+	// tokens line up with old ones behind the edit again, the rest of the tokens are reused.
+	class IncrementalLexer
+	{
+	public:
+		IncrementalLexer(std::string program, intermediate_rep::Interner& names);
+
+		// Replace program[begin, end) with replacement.
+		// If the new program can not be lexed, the exception is passed on and nothing changes.
+		TokenChange edit(std::size_t begin, std::size_t end, std::string_view replacement);
+
+		std::string_view program() const
+		{
+			return source;
+		}
+
+		// Always ends with an Eof token, can be parsed with Parser::Parser{lexer.tokens()}
+		const intermediate_rep::TokenBuffer& tokens() const
+		{
+			return buffer;
+		}
+
+	private:
+		std::string source;
+		intermediate_rep::Interner* interner;
+		intermediate_rep::TokenBuffer buffer;
+	};
+}
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef keywords_hpp
+#define keywords_hpp
+#include "Token/Token.hpp"
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <optional>
+
+namespace Lexer
+{
+	struct Keyword
+	{
+		std::string_view spelling;
+		intermediate_rep::Token::Type type;
+	};
+
+#define KEYWORD_ENTRY(name, spelling) Keyword{spelling, intermediate_rep::Token::Type::name},
+#define KEYWORD_SKIP(name)
+	inline constexpr std::array keywordList{TOKEN_TYPES(KEYWORD_ENTRY, KEYWORD_SKIP)};
+#undef KEYWORD_ENTRY
+#undef KEYWORD_SKIP
+
+	// Perfect hash over keywordList, computed at compile time.
+	// An identifier is hashed from its length, first and last character and compared against a single slot.
+	class KeywordTable
+	{
+	public:
+		static constexpr std::size_t size = 32;
+
+		static constexpr std::uint32_t hash(std::string_view word, std::uint32_t seed)
+		{
+			auto first = static_cast<unsigned char>(word.front());
+			auto last = static_cast<unsigned char>(word.back());
+			return (first * seed + last * 7u + static_cast<std::uint32_t>(word.size()) * 3u) % size;
+		}
+
+		constexpr KeywordTable():
+			seed{findSeed()}
+		{
+			for(auto& keyword : keywordList)
+			{
+				slots[hash(keyword.spelling, seed)] = keyword;
+			}
+		}
+
+		constexpr std::optional<intermediate_rep::Token::Type> find(std::string_view word) const
+		{
+			if(word.size() < minLength || word.size() > maxLength)
+				return std::nullopt;
+
+			auto& slot = slots[hash(word, seed)];
+			if(slot.spelling == word)
+				return slot.type;
+
+			return std::nullopt;
+		}
+
+	private:
+		static constexpr std::uint32_t findSeed()
+		{
+			for(std::uint32_t candidate = 1; candidate < 10000; ++candidate)
+			{
+				std::array<bool, size> used{};
+				bool collision = false;
+				for(auto& keyword : keywordList)
+				{
+					auto h = hash(keyword.spelling, candidate);
+					collision = collision || used[h];
+					used[h] = true;
+				}
+				if(!collision)
+					return candidate;
+			}
+			throw "No perfect hash for the keyword list, increase KeywordTable::size";
+		}
+
+		static constexpr std::size_t minLength = []()
+		{
+			std::size_t length = keywordList.front().spelling.size();
+			for(auto& keyword : keywordList)
+				length = keyword.spelling.size() < length ? keyword.spelling.size() : length;
+			return length;
+		}();
+
+		static constexpr std::size_t maxLength = []()
+		{
+			std::size_t length = 0;
+			for(auto& keyword : keywordList)
+				length = keyword.spelling.size() > length ? keyword.spelling.size() : length;
+			return length;
+		}();
+
+		std::uint32_t seed;
+		std::array<Keyword, size> slots{};
+	};
+
+	inline constexpr KeywordTable keywords{};
+
+	static_assert([]()
+	{
+		for(auto& keyword : keywordList)
+		{
+			if(keywords.find(keyword.spelling) != keyword.type)
+				return false;
+		}
+		return true;
+	}(), "Keyword missing from KeywordTable");
+}
+
+#endif
@@ -1,21 +1,67 @@
 #ifndef lexer_hpp
 #define lexer_hpp
 #include "Token/Token.hpp"
+#include "Token/TokenBuffer.hpp"
+#include "Scanner.hpp"
 #include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
 
 namespace Lexer
 {
-	class Lexer : public intermediate_rep::TokenProducer
+	class Lexer final : public intermediate_rep::TokenProducer
 	{
 	public:
-		Lexer(const std::string& program);
+		// The lexer does not copy the program, tokens refer to it by offset.
+		// The program (e.g. a SourceFile) has to outlive the lexer.
+		// Identifiers are interned into names.
+		Lexer(std::string_view program, intermediate_rep::Interner& names);
+
+		// Only lex program[begin, end), offsets stay relative to the start of program.
+		// begin and end have to be token boundaries.
+		Lexer(std::string_view program, std::size_t begin, std::size_t end, intermediate_rep::Interner& names);
 
 		intermediate_rep::Token next() override;
 
+		std::string_view text(const intermediate_rep::Token& token) override
+		{
+			return intermediate_rep::lexem(token, program, *interner);
+		}
+
+		intermediate_rep::Interner& names() override
+		{
+			return *interner;
+		}
+
+		// Lex the remaining program into buffer, including the final Eof token.
+		// The buffer is cleared first but keeps its capacity.
+		void tokenizeAll(intermediate_rep::TokenBuffer& buffer);
+
+		// Offset where lexing continues
+		std::size_t position() const
+		{
+			return static_cast<std::size_t>(lexemStart - program.data());
+		}
+
 	private:
-		std::string program;
-		std::string::iterator lexemStart;
+		intermediate_rep::Token token(intermediate_rep::Token::Type type, const char* start) const
+		{
+			return {type, static_cast<std::uint32_t>(start - program.data()), static_cast<std::uint32_t>(lexemStart - start)};
+		}
+
+		std::string_view program;
+		intermediate_rep::Interner* interner;
+		const char* lexemStart;
+		const char* programEnd;
+		Scanner scanner;
 	};
+
+	static_assert(intermediate_rep::TokenSource<Lexer>);
+
+	// Same result as Lexer{program}.tokenizeAll(buffer), but the program is split at line starts
+	// and the pieces are lexed on separate threads. threads = 0 uses all hardware threads.
+	void tokenizeParallel(std::string_view program, intermediate_rep::TokenBuffer& buffer, intermediate_rep::Interner& names, unsigned threads = 0);
 }
 
 
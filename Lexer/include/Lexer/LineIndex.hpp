@@ -0,0 +1,34 @@
+#ifndef lineindex_hpp
+#define lineindex_hpp
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+namespace Lexer
+{
+	// Both start at 1, columns count bytes
+	struct SourceLocation
+	{
+		std::size_t line;
+		std::size_t column;
+	};
+
+	// Maps byte offsets into a program to line and column.
+	// Tokens only carry offsets, so the line starts are collected on the first lookup
+	// with one scan over the program instead of being counted while lexing.
+	class LineIndex
+	{
+	public:
+		explicit LineIndex(std::string_view program):
+			program{program}
+		{}
+
+		SourceLocation locate(std::size_t offset);
+
+	private:
+		std::string_view program;
+		std::vector<std::size_t> lineStarts;
+	};
+}
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef scanner_hpp
+#define scanner_hpp
+#include "Token/Token.hpp"
+#include <array>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace Lexer
+{
+	// Character classes driving Lexer::next, one table lookup per character instead of <cctype> calls
+	enum class CharClass : std::uint8_t
+	{
+		Invalid,
+		Space,
+		Alpha,
+		Digit,
+		Quote,
+		SingleChar,	// Token is fully determined by the character, see singleCharToken
+		Compare,	// '=', '<', '>' may be followed by '='
+	};
+
+	inline constexpr std::array<CharClass, 256> charClass = []()
+	{
+		std::array<CharClass, 256> table{};
+		for(char c : {' ', '\t', '\n', '\v', '\f', '\r'})
+			table[static_cast<unsigned char>(c)] = CharClass::Space;
+		for(int c = 'a'; c <= 'z'; ++c)
+			table[c] = CharClass::Alpha;
+		for(int c = 'A'; c <= 'Z'; ++c)
+			table[c] = CharClass::Alpha;
+		for(int c = '0'; c <= '9'; ++c)
+			table[c] = CharClass::Digit;
+		for(char c : {'(', ')', '[', ']', '{', '}', '+', '-', '/', '*', ',', ';'})
+			table[static_cast<unsigned char>(c)] = CharClass::SingleChar;
+		for(char c : {'=', '<', '>'})
+			table[static_cast<unsigned char>(c)] = CharClass::Compare;
+		table['"'] = CharClass::Quote;
+		return table;
+	}();
+
+	inline constexpr std::array<intermediate_rep::Token::Type, 256> singleCharToken = []()
+	{
+		using enum intermediate_rep::Token::Type;
+		std::array<intermediate_rep::Token::Type, 256> table{};
+		table['('] = OParen;
+		table[')'] = CParen;
+		table['['] = OSBracket;
+		table[']'] = CSBracket;
+		table['{'] = OCBracket;
+		table['}'] = CCBracket;
+		table['+'] = Plus;
+		table['-'] = Minus;
+		table['/'] = Slash;
+		table['*'] = Star;
+		table[','] = Comma;
+		table[';'] = Semicolon;
+		return table;
+	}();
+
+	constexpr CharClass classify(char c)
+	{
+		return charClass[static_cast<unsigned char>(c)];
+	}
+
+	// Run scanners: each returns the first position in [begin, end) that is not part of the run.
+	// The vectorized versions never read past end.
+	struct Scanner
+	{
+		using Scan = const char* (*)(const char* begin, const char* end);
+
+		Scan skipSpace;		// whitespace
+		Scan identifier;	// [a-zA-Z0-9]
+		Scan digits;		// [0-9]
+
+		// Appends the offset from program of every character following a '\n' in [begin, end)
+		using Lines = void (*)(const char* program, const char* begin, const char* end, std::vector<std::size_t>& starts);
+
+		Lines lineStarts;
+
+		// Best implementation supported by the executing cpu, selected once
+		static const Scanner& get();
+
+		static const Scanner& scalar();
+	};
+}
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef sourcefile_hpp
+#define sourcefile_hpp
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+namespace Lexer
+{
+	// Read only view of a program on disk.
+	// The file is memory mapped, so the lexer and its tokens can point straight into it
+	// without the program ever being copied.
+	class SourceFile
+	{
+	public:
+		explicit SourceFile(const std::string& path);
+
+		SourceFile(const SourceFile&) = delete;
+		SourceFile& operator=(const SourceFile&) = delete;
+
+		SourceFile(SourceFile&& other) noexcept;
+		SourceFile& operator=(SourceFile&& other) noexcept;
+
+		~SourceFile();
+
+		std::string_view view() const;
+
+	private:
+		void release();
+
+		const char* data = nullptr;
+		std::size_t size = 0;
+
+#if defined(_WIN32)
+		// No mmap available, fall back to reading the whole file
+		std::string contents;
+#endif
+	};
+}
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef streaminglexer_hpp
+#define streaminglexer_hpp
+#include "Lexer.hpp"
+#include "Token/Token.hpp"
+#include <istream>
+#include <vector>
+#include <array>
+#include <optional>
+#include <cstdint>
+#include <cstddef>
+
+namespace Lexer
+{
+	// Lexes a program that is read chunk by chunk from a stream or file descriptor, e.g. a pipe.
+	// Only the text of the most recent tokens and the chunk being lexed are kept in memory.
+	// Token offsets are stream offsets truncated to 32 bit, text() resolves the recent ones.
+	// Identifiers are interned, so their text is always available.
+	class StreamingLexer final : public intermediate_rep::TokenProducer
+	{
+	public:
+		static constexpr std::size_t defaultChunkSize = 64 * 1024;
+
+		StreamingLexer(std::istream& stream, intermediate_rep::Interner& names, std::size_t chunkSize = defaultChunkSize);
+
+#if !defined(_WIN32)
+		// Reads from fd until end of file, the descriptor is not closed
+		StreamingLexer(int fd, intermediate_rep::Interner& names, std::size_t chunkSize = defaultChunkSize);
+#endif
+
+		intermediate_rep::Token next() override;
+
+		std::string_view text(const intermediate_rep::Token& token) override;
+
+		intermediate_rep::Interner& names() override
+		{
+			return *interner;
+		}
+
+	private:
+		// Drop text that is no longer needed, append the next chunk and restart lexing at the cursor
+		void refill();
+
+		std::size_t read(char* dst, std::size_t size);
+
+		intermediate_rep::Interner* interner;
+		std::istream* stream = nullptr;
+		int fd = -1;
+		bool exhausted = false;
+		std::size_t chunkSize;
+
+		std::vector<char> window;
+		std::size_t windowSize = 0;	// bytes of window holding program text
+		std::uint64_t base = 0;		// stream offset of window[0]
+		std::size_t cursor = 0;		// where lexing continues, index into window
+
+		// Lexes window[cursor, end) where end is the last whitespace outside of a string,
+		// no token can straddle it
+		std::optional<Lexer> lexer;
+
+		// Stream offsets of the most recently produced tokens, their text has to survive a refill
+		std::array<std::uint64_t, intermediate_rep::tokenTextHistory> recent{};
+		std::size_t recentIndx = 0;
+	};
+
+	static_assert(intermediate_rep::TokenSource<StreamingLexer>);
+}
+
+#endif
@@ -0,0 +1,170 @@
+#include "IncrementalLexer.hpp"
+#include "Lexer.hpp"
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+#include <bit>
+
+namespace Lexer
+{
+	namespace
+	{
+		using intermediate_rep::Token;
+
+		bool isLiteral(std::uint8_t type)
+		{
+			return type == Token::IntLit || type == Token::FloatLit;
+		}
+
+		bool sameToken(const Token& a, const Token& b)
+		{
+			if(a.type != b.type || a.offset != b.offset)
+			{
+				return false;
+			}
+			switch(a.type)
+			{
+				case Token::IntLit:
+					return a.intValue == b.intValue;
+				case Token::FloatLit:
+					return std::bit_cast<std::uint64_t>(a.floatValue) == std::bit_cast<std::uint64_t>(b.floatValue);
+				case Token::Id:
+					return a.id == b.id;
+				default:
+					return a.length == b.length;
+			}
+		}
+
+		// Replace vec[first, last) with replacement
+		template<typename T>
+		void splice(std::vector<T>& vec, std::size_t first, std::size_t last, const std::vector<T>& replacement)
+		{
+			auto common = std::min(last - first, replacement.size());
+			std::copy_n(replacement.begin(), common, vec.begin() + first);
+			if(common < replacement.size())
+			{
+				vec.insert(vec.begin() + last, replacement.begin() + common, replacement.end());
+			}
+			else
+			{
+				vec.erase(vec.begin() + first + common, vec.begin() + last);
+			}
+		}
+	}
+
+	IncrementalLexer::IncrementalLexer(std::string program, intermediate_rep::Interner& names):
+		source{std::move(program)}, interner{&names}
+	{
+		Lexer{source, names}.tokenizeAll(buffer);
+	}
+
+	TokenChange IncrementalLexer::edit(std::size_t begin, std::size_t end, std::string_view replacement)
+	{
+		if(begin > end || end > source.size())
+		{
+			throw std::runtime_error("Edit out of bounds");
+		}
+
+		auto removed = source.substr(begin, end - begin);
+		source.replace(begin, end - begin, replacement);
+		std::int64_t delta = static_cast<std::int64_t>(replacement.size()) - static_cast<std::int64_t>(removed.size());
+
+		// The last token starting before the edit may run into it or look ahead into it,
+		// all tokens in front of it end before it starts and stay the same.
+		// Without such a token there is only whitespace in front of the edit.
+		auto& offsets = buffer.offsets;
+		std::size_t first = std::lower_bound(offsets.begin(), offsets.end() - 1, begin) - offsets.begin();
+		std::size_t start = 0;
+		if(first > 0)
+		{
+			--first;
+			start = offsets[first];
+		}
+
+		// Relex until a new token starts where an old token behind the edit started,
+		// from there on the program text and so the tokens are the same as before
+		std::vector<Token> relexed;
+		std::size_t resync = first;
+		try
+		{
+			Lexer lexer{source, start, source.size(), *interner};
+			while(true)
+			{
+				auto token = lexer.next();
+				std::int64_t oldOffset = static_cast<std::int64_t>(token.offset) - delta;
+				if(oldOffset >= static_cast<std::int64_t>(end))
+				{
+					while(offsets[resync] < oldOffset)
+					{
+						++resync;
+					}
+					if(offsets[resync] == oldOffset)
+					{
+						break;
+					}
+				}
+				relexed.push_back(token);
+			}
+		}
+		catch(...)
+		{
+			source.replace(begin, replacement.size(), removed);
+			throw;
+		}
+
+		// Tokens in front of the edit that came out unchanged are not part of the change
+		std::size_t same = 0;
+		while(same + 1 < relexed.size() && relexed[same + 1].offset <= begin && sameToken(relexed[same], buffer[first + same]))
+		{
+			++same;
+		}
+		first += same;
+		relexed.erase(relexed.begin(), relexed.begin() + same);
+
+		// Splice the relexed tokens into the struct of arrays
+		std::size_t literalBegin = 0;
+		for(auto i = first; i > 0; --i)
+		{
+			if(isLiteral(buffer.types[i - 1]))
+			{
+				literalBegin = buffer.lengths[i - 1] + 1;
+				break;
+			}
+		}
+		auto literalEnd = literalBegin + std::count_if(buffer.types.begin() + first, buffer.types.begin() + resync, isLiteral);
+
+		intermediate_rep::TokenBuffer changed;
+		for(auto& token : relexed)
+		{
+			changed.push(token);
+		}
+		for(std::size_t i = 0; i < changed.size(); ++i)
+		{
+			if(isLiteral(changed.types[i]))
+			{
+				changed.lengths[i] += static_cast<std::uint32_t>(literalBegin);
+			}
+		}
+
+		std::int64_t literalDelta = static_cast<std::int64_t>(changed.literals.size()) - static_cast<std::int64_t>(literalEnd - literalBegin);
+		splice(buffer.types, first, resync, changed.types);
+		splice(buffer.offsets, first, resync, changed.offsets);
+		splice(buffer.lengths, first, resync, changed.lengths);
+		splice(buffer.literals, literalBegin, literalEnd, changed.literals);
+
+		// Tokens behind the change only moved
+		std::size_t newEnd = first + changed.size();
+		for(auto i = newEnd; i < buffer.size(); ++i)
+		{
+			buffer.offsets[i] = static_cast<std::uint32_t>(buffer.offsets[i] + delta);
+			if(isLiteral(buffer.types[i]))
+			{
+				buffer.lengths[i] = static_cast<std::uint32_t>(buffer.lengths[i] + literalDelta);
+			}
+		}
+		buffer.source = source;
+
+		return {first, resync, newEnd};
+	}
+}
@@ -1,163 +1,132 @@
 #include "Lexer.hpp"
-#include <map>
+#include "Keywords.hpp"
+#include "Token/CompileError.hpp"
 #include <string_view>
 #include <stdexcept>
+#include <limits>
+#include <charconv>
+#include <system_error>
+#include <string>
 
 namespace Lexer
 {
-	const std::map<char, intermediate_rep::Token::Type> singleCharTokens
-	{
-		{'(', intermediate_rep::Token::Type::OParen},
-		{')', intermediate_rep::Token::Type::CParen},
-		{'[', intermediate_rep::Token::Type::OSBracket},
-		{']', intermediate_rep::Token::Type::CSBracket},
-		{'{', intermediate_rep::Token::Type::OCBracket},
-		{'}', intermediate_rep::Token::Type::CCBracket},
-		{'+', intermediate_rep::Token::Type::Plus},
-		{'-', intermediate_rep::Token::Type::Minus},
-		{'/', intermediate_rep::Token::Type::Slash},
-		{'*', intermediate_rep::Token::Type::Star},
-		{',', intermediate_rep::Token::Type::Comma},
-		{';', intermediate_rep::Token::Type::Semicolon},
-	};
+	Lexer::Lexer(std::string_view program, intermediate_rep::Interner& names):
+		Lexer(program, 0, program.size(), names)
+	{}
 
-	const std::map<std::string_view, intermediate_rep::Token::Type> keywords
+	Lexer::Lexer(std::string_view program, std::size_t begin, std::size_t end, intermediate_rep::Interner& names):
+		program{program}, interner{&names}, lexemStart{program.data() + begin}, programEnd{program.data() + end}, scanner{Scanner::get()}
 	{
-		{"and", intermediate_rep::Token::Type::And},
-		{"or", intermediate_rep::Token::Type::Or},
-		{"not", intermediate_rep::Token::Type::Not},
-		{"return", intermediate_rep::Token::Type::Return},
-		{"if", intermediate_rep::Token::Type::If},
-		{"else", intermediate_rep::Token::Type::Else},
-		{"while", intermediate_rep::Token::Type::While},
-		{"true", intermediate_rep::Token::Type::True},
-		{"false", intermediate_rep::Token::Type::False},
-	};
-
-	Lexer::Lexer(const std::string& program):
-		program{program}, lexemStart{this->program.begin()}
-	{}
+		if(program.size() > std::numeric_limits<std::uint32_t>::max())
+		{
+			throw std::runtime_error("Program too large, token offsets are 32 bit");
+		}
+		if(begin > end || end > program.size())
+		{
+			throw std::runtime_error("Lexer range out of bounds");
+		}
+	}
 
 	intermediate_rep::Token Lexer::next()
 	{
-		while(lexemStart != program.end() && std::isspace(*lexemStart))
+		lexemStart = scanner.skipSpace(lexemStart, programEnd);
+
+		if(lexemStart == programEnd)
 		{
-			++lexemStart;
+			return token(intermediate_rep::Token::Eof, lexemStart);
 		}
 
-		if(lexemStart != program.end())
+		auto start = lexemStart;
+
+		switch(classify(*lexemStart))
 		{
-			if(std::isalpha(*lexemStart))
+			case CharClass::Alpha:
 			{
-				auto start = lexemStart;
-				while(std::isalnum(*lexemStart))
-				{
-					++lexemStart;
-				}
-
-				if(keywords.contains({start, lexemStart}))
+				lexemStart = scanner.identifier(lexemStart + 1, programEnd);
+				if(auto keyword = keywords.find({start, static_cast<std::size_t>(lexemStart - start)}))
 				{
-					return {keywords.at({start, lexemStart})};
-				}
-				else
-				{
-					return {intermediate_rep::Token::Id, {start, lexemStart}};
-
+					return token(*keyword, start);
 				}
+				auto identifier = token(intermediate_rep::Token::Id, start);
+				identifier.id = interner->intern({start, static_cast<std::size_t>(lexemStart - start)});
+				return identifier;
 			}
-			else if(std::isdigit(*lexemStart))
+			case CharClass::Digit:
 			{
-				auto start = lexemStart;
-				while(std::isdigit(*lexemStart))
-				{
-					++lexemStart;
-				}
-				if(*lexemStart == '.')
+				lexemStart = scanner.digits(lexemStart + 1, programEnd);
+				if(lexemStart != programEnd && *lexemStart == '.')
 				{
-					++lexemStart;
-					while(std::isdigit(*lexemStart))
+					lexemStart = scanner.digits(lexemStart + 1, programEnd);
+					auto literal = token(intermediate_rep::Token::FloatLit, start);
+					auto [end, error] = std::from_chars(start, lexemStart, literal.floatValue);
+					if(error == std::errc::result_out_of_range)
 					{
-						++lexemStart;
+						throw intermediate_rep::CompileError("Float literal out of range: " + std::string{start, lexemStart}, start - program.data());
 					}
-					return {intermediate_rep::Token::FloatLit, {start, lexemStart}};
+					return literal;
 				}
-				else
+				auto literal = token(intermediate_rep::Token::IntLit, start);
+				auto [end, error] = std::from_chars(start, lexemStart, literal.intValue);
+				if(error == std::errc::result_out_of_range)
 				{
-					return {intermediate_rep::Token::IntLit, {start, lexemStart}};
+					throw intermediate_rep::CompileError("Integer literal out of range: " + std::string{start, lexemStart}, start - program.data());
 				}
+				return literal;
 			}
-			else if(singleCharTokens.contains(*lexemStart))
+			case CharClass::SingleChar:
 			{
-				return {singleCharTokens.at(*(lexemStart++))};
+				++lexemStart;
+				return token(singleCharToken[static_cast<unsigned char>(*start)], start);
 			}
-			else if(*lexemStart == '\"')
+			case CharClass::Quote:
 			{
-				auto start = lexemStart;
 				++lexemStart;
-				while(*lexemStart != '\n' || *lexemStart != '\"')
+				while(lexemStart != programEnd && *lexemStart != '\n' && *lexemStart != '\"')
 				{
 					++lexemStart;
 				}
-				if(*lexemStart == '\n')
+				if(lexemStart == programEnd || *lexemStart == '\n')
 				{
-					throw std::runtime_error("New line in Str Literal");
+					throw intermediate_rep::CompileError("New line in Str Literal", lexemStart - program.data());
 				}
 				++lexemStart;
-				return {intermediate_rep::Token::StrLit, {start, lexemStart}};
+				return token(intermediate_rep::Token::StrLit, start);
 			}
-			else
+			case CharClass::Compare:
 			{
-				switch(*lexemStart)
+				auto first = *(lexemStart++);
+				bool withEqual = lexemStart != programEnd && *lexemStart == '=';
+				if(withEqual)
+				{
+					++lexemStart;
+				}
+				switch(first)
 				{
 					case '=':
-					{
-						++lexemStart;
-						if(*lexemStart == '=')
-						{
-							++lexemStart;
-							return {intermediate_rep::Token::Equal};
-						}
-						else
-						{
-							return {intermediate_rep::Token::Assign};
-						}
-					}
+						return token(withEqual ? intermediate_rep::Token::Equal : intermediate_rep::Token::Assign, start);
 					case '<':
-					{
-						++lexemStart;
-						if(*lexemStart == '=')
-						{
-							++lexemStart;
-							return {intermediate_rep::Token::LessEqual};
-						}
-						else
-						{
-							return {intermediate_rep::Token::Less};
-						}
-					}
-					case '>':
-					{
-						++lexemStart;
-						if(*lexemStart == '=')
-						{
-							++lexemStart;
-							return {intermediate_rep::Token::GreaterEqual};
-						}
-						else
-						{
-							return {intermediate_rep::Token::Greater};
-						}
-					}
+						return token(withEqual ? intermediate_rep::Token::LessEqual : intermediate_rep::Token::Less, start);
 					default:
-						throw std::runtime_error("Unexpected Token");
+						return token(withEqual ? intermediate_rep::Token::GreaterEqual : intermediate_rep::Token::Greater, start);
 				}
 			}
-
+			default:
+				throw intermediate_rep::CompileError("Unexpected Token", start - program.data());
 		}
-		else
+	}
+
+	void Lexer::tokenizeAll(intermediate_rep::TokenBuffer& buffer)
+	{
+		buffer.clear();
+		buffer.source = program;
+		buffer.names = interner;
+
+		intermediate_rep::Token t;
+		do
 		{
-			return {intermediate_rep::Token::Eof};
+			t = next();
+			buffer.push(t);
 		}
+		while(t.type != intermediate_rep::Token::Eof);
 	}
 }
-
@@ -0,0 +1,19 @@
+#include "LineIndex.hpp"
+#include "Scanner.hpp"
+#include <algorithm>
+
+namespace Lexer
+{
+	SourceLocation LineIndex::locate(std::size_t offset)
+	{
+		if(lineStarts.empty())
+		{
+			lineStarts.push_back(0);
+			Scanner::get().lineStarts(program.data(), program.data(), program.data() + program.size(), lineStarts);
+		}
+
+		offset = std::min(offset, program.size());
+		auto line = std::upper_bound(lineStarts.begin(), lineStarts.end(), offset) - 1;
+		return {static_cast<std::size_t>(line - lineStarts.begin()) + 1, offset - *line + 1};
+	}
+}
@@ -0,0 +1,131 @@
+#include "Lexer.hpp"
+#include "Token/Parallel.hpp"
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <limits>
+
+namespace Lexer
+{
+	namespace
+	{
+		// Below this a piece is not worth a thread
+		constexpr std::size_t minPieceSize = 256 * 1024;
+
+		// Tokens never contain a newline (string literals end at one), so lexing can always restart
+		// right after a newline without knowing what came before
+		std::size_t nextLineStart(std::string_view program, std::size_t pos)
+		{
+			auto newline = program.find('\n', pos);
+			return newline == std::string_view::npos ? program.size() : newline + 1;
+		}
+
+		// Identifiers are interned into a piece local interner, the ids are translated when the pieces are joined
+		void lexPiece(std::string_view program, std::size_t begin, std::size_t end, intermediate_rep::TokenBuffer& piece, intermediate_rep::Interner& names)
+		{
+			Lexer lexer{program, begin, end, names};
+			piece.clear();
+			piece.source = program;
+			piece.names = &names;
+			for(auto t = lexer.next(); t.type != intermediate_rep::Token::Eof; t = lexer.next())
+			{
+				piece.push(t);
+			}
+		}
+
+		// Copy piece into buffer starting at token indx.
+		// Literal indices are shifted by literalIndx, local symbol ids are mapped through symbols.
+		void copyPiece(const intermediate_rep::TokenBuffer& piece, intermediate_rep::TokenBuffer& buffer, std::size_t indx, std::size_t literalIndx,
+			const std::vector<intermediate_rep::SymbolId>& symbols)
+		{
+			std::copy(piece.types.begin(), piece.types.end(), buffer.types.begin() + indx);
+			std::copy(piece.offsets.begin(), piece.offsets.end(), buffer.offsets.begin() + indx);
+			std::copy(piece.literals.begin(), piece.literals.end(), buffer.literals.begin() + literalIndx);
+			for(std::size_t i = 0; i < piece.size(); ++i)
+			{
+				switch(piece.types[i])
+				{
+					case intermediate_rep::Token::IntLit:
+					case intermediate_rep::Token::FloatLit:
+						buffer.lengths[indx + i] = piece.lengths[i] + static_cast<std::uint32_t>(literalIndx);
+						break;
+					case intermediate_rep::Token::Id:
+						buffer.lengths[indx + i] = symbols[piece.lengths[i]];
+						break;
+					default:
+						buffer.lengths[indx + i] = piece.lengths[i];
+						break;
+				}
+			}
+		}
+	}
+
+	void tokenizeParallel(std::string_view program, intermediate_rep::TokenBuffer& buffer, intermediate_rep::Interner& names, unsigned threads)
+	{
+		if(program.size() > std::numeric_limits<std::uint32_t>::max())
+		{
+			throw std::runtime_error("Program too large, token offsets are 32 bit");
+		}
+
+		if(threads == 0)
+		{
+			threads = std::max(1u, std::thread::hardware_concurrency());
+		}
+		auto pieces = std::clamp<std::size_t>(program.size() / minPieceSize, 1, threads);
+
+		if(pieces == 1)
+		{
+			Lexer{program, names}.tokenizeAll(buffer);
+			return;
+		}
+
+		std::vector<std::size_t> bounds{0};
+		for(std::size_t i = 1; i < pieces; ++i)
+		{
+			bounds.push_back(std::max(bounds.back(), nextLineStart(program, program.size() * i / pieces)));
+		}
+		bounds.push_back(program.size());
+
+		std::vector<intermediate_rep::TokenBuffer> lexed(pieces);
+		std::vector<intermediate_rep::Interner> localNames(pieces);
+		intermediate_rep::forEachPiece(pieces, [&](std::size_t i)
+		{
+			lexPiece(program, bounds[i], bounds[i + 1], lexed[i], localNames[i]);
+		});
+
+		// Interning the local names piece by piece, each in order of first appearance,
+		// hands out the same ids as sequential lexing would
+		std::vector<std::vector<intermediate_rep::SymbolId>> symbols(pieces);
+		for(std::size_t i = 0; i < pieces; ++i)
+		{
+			for(intermediate_rep::SymbolId id = 0; id < localNames[i].size(); ++id)
+			{
+				symbols[i].push_back(names.intern(localNames[i].name(id)));
+			}
+		}
+
+		std::vector<std::size_t> firstToken{0};
+		std::vector<std::size_t> firstLiteral{0};
+		for(auto& piece : lexed)
+		{
+			firstToken.push_back(firstToken.back() + piece.size());
+			firstLiteral.push_back(firstLiteral.back() + piece.literals.size());
+		}
+
+		buffer.clear();
+		buffer.source = program;
+		buffer.names = &names;
+		buffer.types.resize(firstToken.back());
+		buffer.offsets.resize(firstToken.back());
+		buffer.lengths.resize(firstToken.back());
+		buffer.literals.resize(firstLiteral.back());
+
+		intermediate_rep::forEachPiece(pieces, [&](std::size_t i)
+		{
+			copyPiece(lexed[i], buffer, firstToken[i], firstLiteral[i], symbols[i]);
+		});
+
+		buffer.push({intermediate_rep::Token::Eof, static_cast<std::uint32_t>(program.size()), 0});
+	}
+}
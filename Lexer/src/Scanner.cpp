@@ -0,0 +1,231 @@
+#include "Scanner.hpp"
+#include <bit>
+#include <vector>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define LEXER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// AVX2 code is compiled for a specific function only and picked at runtime,
+// so the binary still runs on cpus without it
+#if defined(LEXER_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define LEXER_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace Lexer
+{
+	namespace
+	{
+		template<CharClass ... classes>
+		const char* scanScalar(const char* begin, const char* end)
+		{
+			while(begin != end && ((classify(*begin) == classes) || ...))
+			{
+				++begin;
+			}
+			return begin;
+		}
+
+		const char* skipSpaceScalar(const char* begin, const char* end)
+		{
+			return scanScalar<CharClass::Space>(begin, end);
+		}
+
+		const char* identifierScalar(const char* begin, const char* end)
+		{
+			return scanScalar<CharClass::Alpha, CharClass::Digit>(begin, end);
+		}
+
+		const char* digitsScalar(const char* begin, const char* end)
+		{
+			return scanScalar<CharClass::Digit>(begin, end);
+		}
+
+		void lineStartsScalar(const char* program, const char* begin, const char* end, std::vector<std::size_t>& starts)
+		{
+			for(; begin != end; ++begin)
+			{
+				if(*begin == '\n')
+				{
+					starts.push_back(static_cast<std::size_t>(begin - program) + 1);
+				}
+			}
+		}
+
+		// One bit per byte of a vector, appends the line start after every set bit
+		inline void pushLineStarts(std::size_t offset, unsigned mask, std::vector<std::size_t>& starts)
+		{
+			while(mask != 0)
+			{
+				starts.push_back(offset + std::countr_zero(mask) + 1);
+				mask &= mask - 1;
+			}
+		}
+
+#if defined(LEXER_SSE2)
+		// Bytes >= 0x80 compare as negative and are therefore never part of a run
+
+		inline __m128i inRange(__m128i v, char low, char high)
+		{
+			return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(low - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8(high + 1)));
+		}
+
+		struct SpaceSse2
+		{
+			static __m128i match(__m128i v)
+			{
+				return _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), inRange(v, '\t', '\r'));
+			}
+		};
+
+		struct IdentifierSse2
+		{
+			static __m128i match(__m128i v)
+			{
+				auto lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+				return _mm_or_si128(inRange(v, '0', '9'), inRange(lower, 'a', 'z'));
+			}
+		};
+
+		struct DigitSse2
+		{
+			static __m128i match(__m128i v)
+			{
+				return inRange(v, '0', '9');
+			}
+		};
+
+		template<typename Matcher, const char* (*tail)(const char*, const char*)>
+		const char* scanSse2(const char* begin, const char* end)
+		{
+			while(end - begin >= 16)
+			{
+				auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+				auto mismatch = ~static_cast<unsigned>(_mm_movemask_epi8(Matcher::match(v))) & 0xFFFFu;
+				if(mismatch != 0)
+				{
+					return begin + std::countr_zero(mismatch);
+				}
+				begin += 16;
+			}
+			return tail(begin, end);
+		}
+
+		void lineStartsSse2(const char* program, const char* begin, const char* end, std::vector<std::size_t>& starts)
+		{
+			auto newline = _mm_set1_epi8('\n');
+			while(end - begin >= 16)
+			{
+				auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+				pushLineStarts(begin - program, static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, newline))), starts);
+				begin += 16;
+			}
+			lineStartsScalar(program, begin, end, starts);
+		}
+#endif
+
+#if defined(LEXER_AVX2)
+#define LEXER_TARGET_AVX2 __attribute__((target("avx2")))
+
+		LEXER_TARGET_AVX2 inline __m256i inRange256(__m256i v, char low, char high)
+		{
+			return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(low - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8(high + 1), v));
+		}
+
+		struct SpaceAvx2
+		{
+			LEXER_TARGET_AVX2 static __m256i match(__m256i v)
+			{
+				return _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), inRange256(v, '\t', '\r'));
+			}
+		};
+
+		struct IdentifierAvx2
+		{
+			LEXER_TARGET_AVX2 static __m256i match(__m256i v)
+			{
+				auto lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+				return _mm256_or_si256(inRange256(v, '0', '9'), inRange256(lower, 'a', 'z'));
+			}
+		};
+
+		struct DigitAvx2
+		{
+			LEXER_TARGET_AVX2 static __m256i match(__m256i v)
+			{
+				return inRange256(v, '0', '9');
+			}
+		};
+
+		template<typename Matcher, const char* (*tail)(const char*, const char*)>
+		LEXER_TARGET_AVX2 const char* scanAvx2(const char* begin, const char* end)
+		{
+			while(end - begin >= 32)
+			{
+				auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+				auto mismatch = ~static_cast<unsigned>(_mm256_movemask_epi8(Matcher::match(v)));
+				if(mismatch != 0)
+				{
+					return begin + std::countr_zero(mismatch);
+				}
+				begin += 32;
+			}
+			return tail(begin, end);
+		}
+
+		LEXER_TARGET_AVX2 void lineStartsAvx2(const char* program, const char* begin, const char* end, std::vector<std::size_t>& starts)
+		{
+			auto newline = _mm256_set1_epi8('\n');
+			while(end - begin >= 32)
+			{
+				auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+				pushLineStarts(begin - program, static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, newline))), starts);
+				begin += 32;
+			}
+			lineStartsSse2(program, begin, end, starts);
+		}
+
+#undef LEXER_TARGET_AVX2
+#endif
+
+		Scanner select()
+		{
+#if defined(LEXER_AVX2)
+			if(__builtin_cpu_supports("avx2"))
+			{
+				return {
+					scanAvx2<SpaceAvx2, scanSse2<SpaceSse2, skipSpaceScalar>>,
+					scanAvx2<IdentifierAvx2, scanSse2<IdentifierSse2, identifierScalar>>,
+					scanAvx2<DigitAvx2, scanSse2<DigitSse2, digitsScalar>>,
+					lineStartsAvx2,
+				};
+			}
+#endif
+#if defined(LEXER_SSE2)
+			return {
+				scanSse2<SpaceSse2, skipSpaceScalar>,
+				scanSse2<IdentifierSse2, identifierScalar>,
+				scanSse2<DigitSse2, digitsScalar>,
+				lineStartsSse2,
+			};
+#else
+			return Scanner::scalar();
+#endif
+		}
+	}
+
+	const Scanner& Scanner::get()
+	{
+		static const Scanner scanner = select();
+		return scanner;
+	}
+
+	const Scanner& Scanner::scalar()
+	{
+		static const Scanner scanner{skipSpaceScalar, identifierScalar, digitsScalar, lineStartsScalar};
+		return scanner;
+	}
+}
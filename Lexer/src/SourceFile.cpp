@@ -0,0 +1,129 @@
+#include "SourceFile.hpp"
+#include <stdexcept>
+#include <utility>
+
+#if defined(_WIN32)
+#include <fstream>
+#include <sstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Lexer
+{
+#if defined(_WIN32)
+	SourceFile::SourceFile(const std::string& path)
+	{
+		std::ifstream file{path, std::ios::binary};
+		if(!file)
+		{
+			throw std::runtime_error("Cannot open " + path);
+		}
+		std::stringstream ss;
+		ss << file.rdbuf();
+		contents = ss.str();
+		data = contents.data();
+		size = contents.size();
+	}
+
+	void SourceFile::release()
+	{
+		contents.clear();
+		data = nullptr;
+		size = 0;
+	}
+
+	SourceFile::SourceFile(SourceFile&& other) noexcept:
+		contents{std::move(other.contents)}
+	{
+		data = contents.data();
+		size = contents.size();
+		other.release();
+	}
+
+	SourceFile& SourceFile::operator=(SourceFile&& other) noexcept
+	{
+		if(this != &other)
+		{
+			contents = std::move(other.contents);
+			data = contents.data();
+			size = contents.size();
+			other.release();
+		}
+		return *this;
+	}
+#else
+	SourceFile::SourceFile(const std::string& path)
+	{
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if(fd < 0)
+		{
+			throw std::runtime_error("Cannot open " + path);
+		}
+
+		struct stat info;
+		if(::fstat(fd, &info) != 0)
+		{
+			::close(fd);
+			throw std::runtime_error("Cannot stat " + path);
+		}
+
+		size = static_cast<std::size_t>(info.st_size);
+
+		// mmap refuses zero length mappings, an empty file is simply an empty view
+		if(size > 0)
+		{
+			void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if(mapping == MAP_FAILED)
+			{
+				::close(fd);
+				throw std::runtime_error("Cannot map " + path);
+			}
+			// The lexer reads the program front to back exactly once
+			::madvise(mapping, size, MADV_SEQUENTIAL);
+			data = static_cast<const char*>(mapping);
+		}
+
+		// The mapping stays valid after the descriptor is closed
+		::close(fd);
+	}
+
+	void SourceFile::release()
+	{
+		if(data != nullptr)
+		{
+			::munmap(const_cast<char*>(data), size);
+		}
+		data = nullptr;
+		size = 0;
+	}
+
+	SourceFile::SourceFile(SourceFile&& other) noexcept:
+		data{std::exchange(other.data, nullptr)}, size{std::exchange(other.size, 0)}
+	{}
+
+	SourceFile& SourceFile::operator=(SourceFile&& other) noexcept
+	{
+		if(this != &other)
+		{
+			release();
+			data = std::exchange(other.data, nullptr);
+			size = std::exchange(other.size, 0);
+		}
+		return *this;
+	}
+#endif
+
+	SourceFile::~SourceFile()
+	{
+		release();
+	}
+
+	std::string_view SourceFile::view() const
+	{
+		return {data, size};
+	}
+}
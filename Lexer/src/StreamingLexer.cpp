@@ -0,0 +1,170 @@
+#include "StreamingLexer.hpp"
+#include "Scanner.hpp"
+#include "Token/CompileError.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+namespace Lexer
+{
+	StreamingLexer::StreamingLexer(std::istream& stream, intermediate_rep::Interner& names, std::size_t chunkSize):
+		interner{&names}, stream{&stream}, chunkSize{chunkSize}
+	{
+		if(chunkSize == 0)
+		{
+			throw std::runtime_error("Chunk size has to be positive");
+		}
+	}
+
+#if !defined(_WIN32)
+	StreamingLexer::StreamingLexer(int fd, intermediate_rep::Interner& names, std::size_t chunkSize):
+		interner{&names}, fd{fd}, chunkSize{chunkSize}
+	{
+		if(chunkSize == 0)
+		{
+			throw std::runtime_error("Chunk size has to be positive");
+		}
+	}
+#endif
+
+	std::size_t StreamingLexer::read(char* dst, std::size_t size)
+	{
+		if(stream)
+		{
+			stream->read(dst, static_cast<std::streamsize>(size));
+			if(stream->bad())
+			{
+				throw std::runtime_error("Error reading program");
+			}
+			return static_cast<std::size_t>(stream->gcount());
+		}
+#if !defined(_WIN32)
+		while(true)
+		{
+			auto n = ::read(fd, dst, size);
+			if(n >= 0)
+			{
+				return static_cast<std::size_t>(n);
+			}
+			if(errno != EINTR)
+			{
+				throw std::runtime_error("Error reading program");
+			}
+		}
+#else
+		return 0;
+#endif
+	}
+
+	void StreamingLexer::refill()
+	{
+		// Keep the text of the recent tokens, everything before it can go
+		auto keep = base + cursor;
+		for(auto offset : recent)
+		{
+			keep = std::min(keep, std::max(offset, base));
+		}
+		auto drop = static_cast<std::size_t>(keep - base);
+		if(drop > 0)
+		{
+			std::memmove(window.data(), window.data() + drop, windowSize - drop);
+			windowSize -= drop;
+			cursor -= drop;
+			base = keep;
+		}
+
+		// The window only grows if the retained text leaves no room for a chunk
+		if(window.size() - windowSize < chunkSize)
+		{
+			window.resize(windowSize + chunkSize);
+		}
+		auto n = read(window.data() + windowSize, chunkSize);
+		windowSize += n;
+		exhausted = n == 0;
+
+		// Find the last whitespace outside of a string literal, tokens never cross it.
+		// Strings end at a newline, so a newline always closes them.
+		std::size_t end = cursor;
+		if(exhausted)
+		{
+			end = windowSize;
+		}
+		else
+		{
+			bool inString = false;
+			for(std::size_t i = cursor; i < windowSize; ++i)
+			{
+				char c = window[i];
+				if(c == '"')
+				{
+					inString = !inString;
+				}
+				else if(c == '\n' || (!inString && classify(c) == CharClass::Space))
+				{
+					inString = false;
+					end = i + 1;
+				}
+			}
+		}
+
+		lexer.emplace(std::string_view{window.data(), windowSize}, cursor, end, *interner);
+	}
+
+	intermediate_rep::Token StreamingLexer::next()
+	{
+		while(true)
+		{
+			if(lexer)
+			{
+				intermediate_rep::Token token;
+				try
+				{
+					token = lexer->next();
+				}
+				catch(const intermediate_rep::CompileError& e)
+				{
+					// The lexer only sees the window
+					throw intermediate_rep::CompileError(e.what(), base + e.offset());
+				}
+				cursor = lexer->position();
+
+				if(token.type != intermediate_rep::Token::Eof)
+				{
+					auto offset = base + token.offset;
+					recent[recentIndx++ % recent.size()] = offset;
+					token.offset = static_cast<std::uint32_t>(offset);
+					return token;
+				}
+
+				if(exhausted && cursor == windowSize)
+				{
+					token.offset = static_cast<std::uint32_t>(base + cursor);
+					return token;
+				}
+			}
+			refill();
+		}
+	}
+
+	std::string_view StreamingLexer::text(const intermediate_rep::Token& token)
+	{
+		if(token.type == intermediate_rep::Token::Id)
+		{
+			return interner->name(token.id);
+		}
+
+		// Offsets wrap at 32 bit, the difference to the window start is still exact
+		auto relative = token;
+		relative.offset = token.offset - static_cast<std::uint32_t>(base);
+		if(relative.offset > windowSize)
+		{
+			throw std::runtime_error("Token text no longer available");
+		}
+		return intermediate_rep::lexem(relative, std::string_view{window.data(), windowSize}, *interner);
+	}
+}
@@ -2,12 +2,21 @@
 #define parser_hpp
 
 #include "Token/Token.hpp"
+#include "Token/TokenBuffer.hpp"
+#include "Token/CompileError.hpp"
+#include "Lexer/Lexer.hpp"
 #include "Ast/Ast.hpp"
 #include "Ast/SymbolTable.hpp"
 #include <memory>
 #include <stdexcept>
 #include <utility>
 #include <map>
+#include <array>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
 
 namespace Parser
 {
@@ -19,62 +28,123 @@ namespace Parser
 		Left,Right
 	};
 
-	const std::map<ast::BinaryOperator, std::pair<int, Associativity>> operatorPrecedence
+	// Pratt style operator table, indexed by Token::Type.
+	// A token can start an expression as prefix operator and continue one as infix operator,
+	// a power of 0 means it has no such role. Higher powers bind tighter.
+	struct OperatorRule
 	{
-		{ast::BinaryOperator::Assign, {0, Associativity::Right}},
-		{ast::BinaryOperator::Or, {10, Associativity::Left}},
-		{ast::BinaryOperator::And, {20, Associativity::Left}},
-		{ast::BinaryOperator::Equal, {30, Associativity::Left}},
-		{ast::BinaryOperator::NotEqual, {30, Associativity::Left}},
-		{ast::BinaryOperator::Less, {40, Associativity::Left}},
-		{ast::BinaryOperator::LessEqual, {40, Associativity::Left}},
-		{ast::BinaryOperator::Greater, {40, Associativity::Left}},
-		{ast::BinaryOperator::GreaterEqual, {40, Associativity::Left}},
-		{ast::BinaryOperator::Add, {50, Associativity::Left}},
-		{ast::BinaryOperator::Sub, {50, Associativity::Left}},
-		{ast::BinaryOperator::Mul, {60, Associativity::Left}},
-		{ast::BinaryOperator::Div, {60, Associativity::Left}},
+		std::uint8_t prefixPower = 0;
+		ast::UnaryOperator unary{};
+		std::uint8_t infixPower = 0;
+		Associativity assoc = Associativity::Left;
+		ast::BinaryOperator binary{};
 	};
 
+	inline constexpr auto operatorRules = []()
+	{
+		using Token = intermediate_rep::Token;
+		using enum Associativity;
+		std::array<OperatorRule, intermediate_rep::tokenTypeCount> rules{};
+
+		auto infix = [&](Token::Type type, std::uint8_t power, Associativity assoc, ast::BinaryOperator op)
+		{
+			rules[type].infixPower = power;
+			rules[type].assoc = assoc;
+			rules[type].binary = op;
+		};
+		auto prefix = [&](Token::Type type, std::uint8_t power, ast::UnaryOperator op)
+		{
+			rules[type].prefixPower = power;
+			rules[type].unary = op;
+		};
+
+		infix(Token::Assign, 10, Right, ast::BinaryOperator::Assign);
+		infix(Token::Or, 20, Left, ast::BinaryOperator::Or);
+		infix(Token::And, 30, Left, ast::BinaryOperator::And);
+		// not a == b is not (a == b), not a and b is (not a) and b
+		prefix(Token::Not, 35, ast::UnaryOperator::Not);
+		infix(Token::Equal, 40, Left, ast::BinaryOperator::Equal);
+		infix(Token::NotEqual, 40, Left, ast::BinaryOperator::NotEqual);
+		infix(Token::Less, 50, Left, ast::BinaryOperator::Less);
+		infix(Token::LessEqual, 50, Left, ast::BinaryOperator::LessEqual);
+		infix(Token::Greater, 50, Left, ast::BinaryOperator::Greater);
+		infix(Token::GreaterEqual, 50, Left, ast::BinaryOperator::GreaterEqual);
+		infix(Token::Plus, 60, Left, ast::BinaryOperator::Add);
+		infix(Token::Minus, 60, Left, ast::BinaryOperator::Sub);
+		infix(Token::Star, 70, Left, ast::BinaryOperator::Mul);
+		infix(Token::Slash, 70, Left, ast::BinaryOperator::Div);
+		prefix(Token::Minus, 80, ast::UnaryOperator::Negate);
+		return rules;
+	}();
+
+	// Parser, instantiated for the token sources below.
+	// Custom token producers go through intermediate_rep::ProducerSource.
+	// Statements and expressions are parsed with explicit stacks instead of recursion, so deeply nested
+	// input does not overflow the call stack. Nesting beyond maxNesting is reported as a CompileError.
+	template<intermediate_rep::TokenSource Source>
 	class Parser
 	{
 	public:
 
-		Parser(intermediate_rep::TokenProducer* tokenProducer);
+		// Every later stage walks the program without recursion too, so the limit
+		// only bounds memory and time. Compiler/test/NestingLimit.cpp checks it.
+		static constexpr std::size_t defaultMaxNesting = 100000;
+
+		Parser(Source source, std::size_t maxNesting = defaultMaxNesting);
 
 		auto program() -> ast::Program;
 
+		// Parses in two phases on up to threads threads (0: one per core). A pre-scan puts all function
+		// signatures into the globals and skips the bodies by matching braces, then the bodies are parsed
+		// in parallel, each worker with its own scopes and arena.
+		// Gives the same Program as program(), but functions can also call functions defined after them.
+		auto programParallel(unsigned threads = 0) -> ast::Program
+			requires std::same_as<Source, intermediate_rep::TokenBufferReader>;
+
 	private:
 
+		// Worker for programParallel, uses the type names of parent and no globals of its own
+		Parser(Source source, const Parser& parent);
+
 		auto function() -> ast::Function;
 
-		// Statements
+		// ReturnType Name (Type name, ....), leaves the parameter scope open
+		auto signature() -> intermediate_rep::SymbolTable::Function&;
 
-		auto stmt() -> std::unique_ptr<ast::Statement>;
+		// Skips a block by matching braces, without parsing its statements
+		void skipBlock();
 
-		auto exprStmt() -> std::unique_ptr<ast::ExprStmt>;
+		// Statements
 
-		auto ifStmt() -> std::unique_ptr<ast::IfStmt> ;
+		// Parses one statement including everything nested in it
+		auto stmt() -> ast::Statement*;
 
-		auto whileStmt() -> std::unique_ptr<ast::WhileStmt>;
+		auto exprStmt() -> ast::ExprStmt*;
 
-		auto returnStmt() -> std::unique_ptr<ast::ReturnStmt>;
+		auto returnStmt() -> ast::ReturnStmt*;
 
-		auto block() -> std::unique_ptr<ast::Block>;
+		auto block() -> ast::Block*;
 
-		auto varDecl() -> std::unique_ptr<ast::ExprStmt>;
+		auto varDecl() -> ast::ExprStmt*;
 
 		// Expressions
 
-		auto expr() -> std::unique_ptr<ast::Expression>;
+		auto expr() -> ast::Expression*;
+
+		auto constant() -> ast::Expression*;
 
-		auto binaryExpr() -> std::unique_ptr<ast::Expression>;
+		// Throws if depth open statements, parentheses and calls are too many
+		void nest(std::size_t depth);
 
-		auto binaryExpr_h(std::unique_ptr<ast::Expression> left, int min_precedence) -> std::unique_ptr<ast::Expression>;
+		// Names, unknown, misused and redefined ones are reported at their token
 
-		auto unaryExpr() -> std::unique_ptr<ast::Expression>;
+		auto typeOf(const intermediate_rep::Token& type) -> intermediate_rep::SymbolTable::Variable::Type;
 
-		auto primaryExpr() -> std::unique_ptr<ast::Expression>;
+		template<typename T>
+		auto declare(const intermediate_rep::Token& name, T symbol) -> T&;
+
+		template<typename T>
+		auto resolve(const intermediate_rep::Token& name) -> T&;
 
 
 		// Check if the next token has any of the following types
@@ -88,19 +158,80 @@ namespace Parser
 		// advance the stream unconditionally
 		void advance();
 
-		intermediate_rep::TokenProducer* tokenProducer;
+		std::string_view text(const intermediate_rep::Token& token);
+
+		Source source;
+		// Interned names of the builtin types
+		std::map<intermediate_rep::SymbolId, intermediate_rep::SymbolTable::Variable::Type> typeNames;
 		std::unique_ptr<intermediate_rep::SymbolTable> globals;
 		intermediate_rep::SymbolTableBuilder builder;
 		intermediate_rep::Token next;
+		// Nodes go here and move into the Program
+		intermediate_rep::Arena arena;
+		// Children of the blocks and calls being parsed, copied into the arena once complete
+		std::vector<ast::Statement*> pendingStmts;
+		std::vector<ast::Expression*> pendingArgs;
+
+		// Compound statement still waiting for its body, else branch or closing bracket
+		struct Frame
+		{
+			enum class Kind : std::uint8_t
+			{
+				Block, If, Else, While
+			} kind;
+			ast::Expression* condition = nullptr;
+			ast::Statement* trueStmt = nullptr;
+			std::size_t first = 0;	// of the Block's statements in pendingStmts
+		};
+
+		// Operator waiting for its (right) operand, or an open parenthesis or call
+		struct Operator
+		{
+			enum class Kind : std::uint8_t
+			{
+				Prefix, Infix, Paren, Call
+			} kind;
+			std::uint8_t power = 0;
+			ast::UnaryOperator unary{};
+			ast::BinaryOperator binary{};
+			intermediate_rep::SymbolTable::Function* function = nullptr;
+			std::size_t firstArg = 0;	// of the Call's arguments in pendingArgs
+		};
+
+		std::size_t maxNesting;
+		std::vector<Frame> frames;
+		std::vector<Operator> operators;
+		// nullptr stands for the missing argument of an empty call
+		std::vector<ast::Expression*> operands;
 	};
 
+	Parser(intermediate_rep::TokenProducer*) -> Parser<intermediate_rep::ProducerSource>;
+	Parser(intermediate_rep::TokenProducer*, std::size_t) -> Parser<intermediate_rep::ProducerSource>;
+	Parser(const intermediate_rep::TokenBuffer&) -> Parser<intermediate_rep::TokenBufferReader>;
+	Parser(const intermediate_rep::TokenBuffer&, std::size_t) -> Parser<intermediate_rep::TokenBufferReader>;
+
+	extern template class Parser<Lexer::Lexer>;
+	extern template class Parser<intermediate_rep::TokenBufferReader>;
+	extern template class Parser<intermediate_rep::ProducerSource>;
 
+	template<intermediate_rep::TokenSource Source>
+	inline void Parser<Source>::advance()
+	{
+		next = source.next();
+	}
+
+	template<intermediate_rep::TokenSource Source>
+	inline std::string_view Parser<Source>::text(const intermediate_rep::Token& token)
+	{
+		return source.text(token);
+	}
 
+	template<intermediate_rep::TokenSource Source>
 	template<std::same_as<intermediate_rep::Token::Type> ... TArgs>
-	intermediate_rep::Token Parser::consume(intermediate_rep::Token::Type type, TArgs ... types)
+	intermediate_rep::Token Parser<Source>::consume(intermediate_rep::Token::Type type, TArgs ... types)
 	{
 		if(next.type != type)
-			throw std::runtime_error("Expected " + intermediate_rep::tokenTypeToStr(type) + " but got (" + intermediate_rep::tokenTypeToStr(next.type) + ", " +next.lexem  + ")");
+			throw intermediate_rep::CompileError("Expected " + intermediate_rep::tokenTypeToStr(type) + " but got (" + intermediate_rep::tokenTypeToStr(next.type) + ", " + std::string{text(next)} + ")", next.offset);
 
 		if constexpr(sizeof...(types) > 0)
 		{
@@ -109,12 +240,13 @@ namespace Parser
 		}
 		else
 		{
-			return std::exchange(next, tokenProducer->next());
+			return std::exchange(next, source.next());
 		}
 	}	
 
+	template<intermediate_rep::TokenSource Source>
 	template<std::same_as<intermediate_rep::Token::Type> ... TArgs>
-	bool Parser::match(intermediate_rep::Token::Type type, TArgs ... types)
+	bool Parser<Source>::match(intermediate_rep::Token::Type type, TArgs ... types)
 	{
 		if(next.type == type)
 			return true;
@@ -1,9 +1,14 @@
 #include "Parser.hpp"
+#include "Token/Parallel.hpp"
 #include <vector>
 #include <map>
 #include <string_view>
 #include <optional>
 #include <utility>
+#include <limits>
+#include <algorithm>
+#include <thread>
+#include <exception>
 
 namespace Parser
 {
@@ -11,6 +16,9 @@ namespace Parser
 	using namespace intermediate_rep;
 
 
+	// Below this many tokens a piece of programParallel is not worth a thread
+	constexpr std::size_t minPieceTokens = 64 * 1024;
+
 	const std::map<std::string_view, SymbolTable::Variable::Type> strToVarType
 	{
 		{"int", SymbolTable::Variable::Type::Int},
@@ -20,100 +28,130 @@ namespace Parser
 	};
 
 
-	ast::BinaryOperator tokenToBinOp(Token::Type type)
+	template<TokenSource Source>
+	Parser<Source>::Parser(Source source, std::size_t maxNesting):
+		source{std::move(source)}, globals{std::make_unique<SymbolTable>()}, builder{globals.get()}, maxNesting{maxNesting}
 	{
-		using enum ast::BinaryOperator;
-		switch(type)
+		for(auto& [name, type] : strToVarType)
 		{
-			case Token::Type::Plus:
-				return Add;
-			case Token::Type::Minus:
-				return Sub;
-			case Token::Type::Star:
-				return Mul;
-			case Token::Type::Slash:
-				return Div;
-			case Token::Type::Less:
-				return Less;
-			case Token::Type::Greater:
-				return Greater;
-			case Token::Type::LessEqual:
-				return LessEqual;
-			case Token::Type::GreaterEqual:
-				return GreaterEqual;
-			case Token::Type::Equal:
-				return Equal;
-			case Token::Type::NotEqual:
-				return NotEqual;
-			case Token::Type::And:
-				return And;
-			case Token::Type::Or:
-				return Or;
-			case Token::Type::Assign:
-				return Assign;
-			default:
-				throw std::runtime_error("Token is not a binary Operator");
+			typeNames.emplace(this->source.names().intern(name), type);
 		}
+		next = this->source.next();
 	}
 
-	bool isBinaryOperator(Token::Type type)
+	template<TokenSource Source>
+	auto Parser<Source>::program() -> ast::Program
 	{
-		using enum Token::Type;
-		switch(type)
+		std::vector<ast::Function> functions;
+
+		while(!match(Token::Type::Eof))
 		{
-			case Plus:
-			case Minus:
-			case Star:
-			case Slash:
-			case Less:
-			case LessEqual:
-			case Greater:
-			case GreaterEqual:
-			case Equal:
-			case NotEqual:
-			case Assign:
-			case And:
-			case Or:
-				return true;
-			default:
-				return false;
+			functions.push_back(function());
 		}
-	}
 
-	Parser::Parser(TokenProducer* tokenProducer):
-		tokenProducer{tokenProducer}, globals{std::make_unique<SymbolTable>()}, builder{globals.get()}
-	{
-		next = tokenProducer->next();
+		// Parser left in invalid state; Maybe fix it later?
+		return {std::move(globals), std::move(functions), &source.names(), std::move(arena)};
 	}
 
-	void Parser::advance()
+
+	template<TokenSource Source>
+	Parser<Source>::Parser(Source source, const Parser& parent):
+		source{std::move(source)}, typeNames{parent.typeNames}, builder{nullptr}, maxNesting{parent.maxNesting}
 	{
-		next = tokenProducer->next();
+		next = this->source.next();
 	}
 
-	auto Parser::program() -> ast::Program
+	template<TokenSource Source>
+	auto Parser<Source>::programParallel(unsigned threads) -> ast::Program
+		requires std::same_as<Source, TokenBufferReader>
 	{
+		// Pre-scan, stops at the first error. Workers still parse the functions before it,
+		// their errors come first in the program
 		std::vector<ast::Function> functions;
+		std::vector<std::size_t> bodies;
+		std::exception_ptr scanError;
+		try
+		{
+			while(!match(Token::Type::Eof))
+			{
+				auto& func = signature();
+				builder.pop();
+				if(!match(Token::Type::OCBracket))
+				{
+					consume(Token::Type::OCBracket);
+				}
+				functions.push_back({&func, nullptr});
+				// next is the '{', the reader is one token ahead
+				bodies.push_back(source.position() - 1);
+				skipBlock();
+			}
+		}
+		catch(...)
+		{
+			scanError = std::current_exception();
+		}
+		bodies.push_back(source.position());
 
-		while(!match(Token::Type::Eof))
+		if(threads == 0)
 		{
-			functions.push_back(function());
+			threads = std::max(1u, std::thread::hardware_concurrency());
 		}
+		auto tokens = bodies.back() - bodies.front();
+		auto pieces = std::clamp<std::size_t>(tokens / minPieceTokens, 1, threads);
 
-		// Parser left in invalid state; Maybe fix it later?
-		return {std::move(globals), std::move(functions)};
+		// Piece i parses the functions whose bodies start in its share of the tokens
+		std::vector<std::size_t> bounds{0};
+		for(std::size_t i = 1; i < pieces; ++i)
+		{
+			auto first = std::lower_bound(bodies.begin(), bodies.end() - 1, bodies.front() + tokens * i / pieces);
+			bounds.push_back(std::max(bounds.back(), static_cast<std::size_t>(first - bodies.begin())));
+		}
+		bounds.push_back(functions.size());
+
+		std::vector<Arena> arenas(pieces);
+		forEachPiece(pieces, [&](std::size_t i)
+		{
+			Parser worker{source, *this};
+			for(auto k = bounds[i]; k < bounds[i + 1]; ++k)
+			{
+				worker.source.seek(bodies[k]);
+				worker.advance();
+				worker.builder = SymbolTableBuilder{functions[k].sym_entry->parameter_scope};
+				functions[k].block = worker.block();
+			}
+			arenas[i] = std::move(worker.arena);
+		});
+
+		if(scanError)
+		{
+			std::rethrow_exception(scanError);
+		}
+
+		for(auto& piece : arenas)
+		{
+			arena.adopt(std::move(piece));
+		}
+		return {std::move(globals), std::move(functions), &source.names(), std::move(arena)};
 	}
 
+	template<TokenSource Source>
+	auto Parser<Source>::function() -> ast::Function
+	{
+		auto& func = signature();
+		auto body = block();
+		builder.pop();
+		return {&func, body};
+	}
 
-	// ReturnType Name (Type name, ....){}
-	auto Parser::function() -> ast::Function
+	template<TokenSource Source>
+	auto Parser<Source>::signature() -> SymbolTable::Function&
 	{
-		// Create Parameter Scope
 		auto returnType = consume(Token::Type::Id);
 		auto name = consume(Token::Type::Id);
 
-		auto& func = builder.top()->insert(name.lexem, SymbolTable::Function{name.lexem, strToVarType.at(returnType.lexem)});
-		ScopeGuard guard{builder};
+		auto& func = declare(name, SymbolTable::Function{name.id, text(name), typeOf(returnType)});
+		// Create Parameter Scope
+		builder.push();
 		func.parameter_scope = builder.top();
 		consume(Token::Type::OParen);
 		while(match(Token::Type::Id))
@@ -121,9 +159,10 @@ namespace Parser
 			auto type = consume(Token::Type::Id);
 			auto name = consume(Token::Type::Id);
 
-			func.parameters.push_back(&builder.top()->insert(name.lexem, SymbolTable::Variable{
-				name.lexem,
-				strToVarType.at(type.lexem),
+			func.parameters.push_back(&declare(name, SymbolTable::Variable{
+				name.id,
+				text(name),
+				typeOf(type),
 			}));
 
 			if(match(Token::Type::Comma))
@@ -132,241 +171,392 @@ namespace Parser
 			}
 		}
 		consume(Token::Type::CParen);
-		return {&func, block()};
+		return func;
 	}
 
-	auto Parser::stmt() -> std::unique_ptr<ast::Statement>
+	template<TokenSource Source>
+	void Parser<Source>::skipBlock()
 	{
-		switch(next.type)
+		std::size_t depth = 0;
+		do
 		{
-			case Token::Type::While:
-				return whileStmt();
-			case Token::Type::If:
-				return ifStmt();
-			case Token::Type::Return:
-				return returnStmt();
-			case Token::Type::OCBracket:
-				return block();
-			case Token::Type::Id:
+			if(match(Token::Type::OCBracket))
 			{
-				if(strToVarType.contains(next.lexem))
-				{
-					return varDecl();
-				}
+				depth++;
 			}
-			default:
-				return exprStmt();
+			else if(match(Token::Type::CCBracket))
+			{
+				depth--;
+			}
+			else if(match(Token::Type::Eof))
+			{
+				consume(Token::Type::CCBracket);
+			}
+			advance();
 		}
-	} 
+		while(depth > 0);
+	}
 
-	auto Parser::whileStmt() -> std::unique_ptr<ast::WhileStmt>
+	template<TokenSource Source>
+	void Parser<Source>::nest(std::size_t depth)
 	{
-		consume(Token::Type::While, Token::Type::OParen);
-		auto condition = expr();
-		consume(Token::Type::CParen);
-		auto statement = stmt();
-		return std::make_unique<ast::WhileStmt>(std::move(condition), std::move(statement));
+		if(depth >= maxNesting)
+		{
+			throw CompileError("Nesting deeper than " + std::to_string(maxNesting) + " levels", next.offset);
+		}
 	}
 
-	auto Parser::ifStmt() -> std::unique_ptr<ast::IfStmt>
+	template<TokenSource Source>
+	auto Parser<Source>::typeOf(const Token& type) -> SymbolTable::Variable::Type
 	{
-		consume(Token::Type::If, Token::Type::OParen);
-		auto condition = expr();
-		consume(Token::Type::CParen);
-		auto trueStmt = stmt();
-		decltype(trueStmt) falseStmt;
-		if(match(Token::Type::Else))
+		auto iter = typeNames.find(type.id);
+		if(iter == typeNames.end())
 		{
-			advance();
-			falseStmt = stmt();
+			throw CompileError("Unknown type: " + std::string{text(type)}, type.offset);
 		}
-		return std::make_unique<ast::IfStmt>(std::move(condition), std::move(trueStmt), std::move(falseStmt));
+		return iter->second;
 	}
 
-	auto Parser::returnStmt() -> std::unique_ptr<ast::ReturnStmt>
+	template<TokenSource Source>
+	template<typename T>
+	auto Parser<Source>::declare(const Token& name, T symbol) -> T&
+	{
+		if(builder.top()->declares(name.id))
+		{
+			throw CompileError("Already defined: " + std::string{text(name)}, name.offset);
+		}
+		return builder.top()->insert(name.id, std::move(symbol));
+	}
+
+	template<TokenSource Source>
+	template<typename T>
+	auto Parser<Source>::resolve(const Token& name) -> T&
+	{
+		auto symbol = builder.top()->lookup(name.id);
+		if(symbol == nullptr)
+		{
+			throw CompileError("Undefined name: " + std::string{text(name)}, name.offset);
+		}
+		auto ptr = std::get_if<T>(symbol);
+		if(ptr == nullptr)
+		{
+			constexpr auto kind = std::same_as<T, SymbolTable::Function> ? "Not a function: " : "Not a variable: ";
+			throw CompileError(kind + std::string{text(name)}, name.offset);
+		}
+		return *ptr;
+	}
+
+	// Compound statements are opened on the frames stack and closed once their last part is parsed,
+	// so nesting depth only costs heap memory
+	template<TokenSource Source>
+	auto Parser<Source>::stmt() -> ast::Statement*
+	{
+		auto base = frames.size();
+		while(true)
+		{
+			ast::Statement* statement = nullptr;
+			switch(next.type)
+			{
+				case Token::Type::While:
+				case Token::Type::If:
+				{
+					auto kind = match(Token::Type::While) ? Frame::Kind::While : Frame::Kind::If;
+					nest(frames.size());
+					advance();
+					consume(Token::Type::OParen);
+					auto condition = expr();
+					consume(Token::Type::CParen);
+					frames.push_back({kind, condition});
+					continue;
+				}
+				case Token::Type::OCBracket:
+					nest(frames.size());
+					builder.push();
+					advance();
+					frames.push_back({Frame::Kind::Block, nullptr, nullptr, pendingStmts.size()});
+					break;
+				case Token::Type::Return:
+					statement = returnStmt();
+					break;
+				case Token::Type::Id:
+					statement = typeNames.contains(next.id) ? varDecl() : exprStmt();
+					break;
+				default:
+					statement = exprStmt();
+					break;
+			}
+
+			while(frames.size() > base)
+			{
+				auto& frame = frames.back();
+				if(frame.kind == Frame::Kind::Block)
+				{
+					if(statement != nullptr)
+					{
+						pendingStmts.push_back(statement);
+					}
+					if(!match(Token::Type::CCBracket))
+					{
+						break;
+					}
+					advance();
+					builder.pop();
+					auto stmts = arena.copy(std::span<ast::Statement* const>{pendingStmts}.subspan(frame.first));
+					pendingStmts.resize(frame.first);
+					statement = arena.make<ast::Block>(stmts);
+				}
+				else if(frame.kind == Frame::Kind::If && match(Token::Type::Else))
+				{
+					advance();
+					frame.kind = Frame::Kind::Else;
+					frame.trueStmt = statement;
+					break;
+				}
+				else if(frame.kind == Frame::Kind::If)
+				{
+					statement = arena.make<ast::IfStmt>(frame.condition, statement, nullptr);
+				}
+				else if(frame.kind == Frame::Kind::Else)
+				{
+					statement = arena.make<ast::IfStmt>(frame.condition, frame.trueStmt, statement);
+				}
+				else
+				{
+					statement = arena.make<ast::WhileStmt>(frame.condition, statement);
+				}
+				frames.pop_back();
+			}
+
+			if(frames.size() == base)
+			{
+				return statement;
+			}
+		}
+	}
+
+	template<TokenSource Source>
+	auto Parser<Source>::block() -> ast::Block*
+	{
+		if(!match(Token::Type::OCBracket))
+		{
+			consume(Token::Type::OCBracket);
+		}
+		return static_cast<ast::Block*>(stmt());
+	}
+
+	template<TokenSource Source>
+	auto Parser<Source>::returnStmt() -> ast::ReturnStmt*
 	{
 		consume(Token::Type::Return);
 		if(match(Token::Type::Semicolon))
 		{
 			advance();
-			return std::make_unique<ast::ReturnStmt>();
+			return arena.make<ast::ReturnStmt>();
 		}
 		else
 		{
 			auto expression = expr();
 			consume(Token::Type::Semicolon);
-			return std::make_unique<ast::ReturnStmt>(std::move(expression));
+			return arena.make<ast::ReturnStmt>(expression);
 		}
 	}
 
-	auto Parser::exprStmt() -> std::unique_ptr<ast::ExprStmt>
+	template<TokenSource Source>
+	auto Parser<Source>::exprStmt() -> ast::ExprStmt*
 	{
 		auto expression = expr();
 		consume(Token::Type::Semicolon);
-		return std::make_unique<ast::ExprStmt>(std::move(expression));
+		return arena.make<ast::ExprStmt>(expression);
 	}
 
-	auto Parser::varDecl() -> std::unique_ptr<ast::ExprStmt>
+	template<TokenSource Source>
+	auto Parser<Source>::varDecl() -> ast::ExprStmt*
 	{
 		auto type = consume(Token::Type::Id);
 		auto name = consume(Token::Type::Id);
 
-		auto& var = builder.top()->insert(name.lexem, SymbolTable::Variable{
-			name.lexem,
-			strToVarType.at(type.lexem)
+		auto& var = declare(name, SymbolTable::Variable{
+			name.id,
+			text(name),
+			typeOf(type)
 		});
 
 		consume(Token::Type::Assign);
 		auto expression = expr();
 		consume(Token::Type::Semicolon);
-		return std::make_unique<ast::ExprStmt>(
-			std::make_unique<ast::BinaryExpression>(
-				std::make_unique<ast::Variable>(&var),
-				std::move(expression),
+		return arena.make<ast::ExprStmt>(
+			arena.make<ast::BinaryExpression>(
+				arena.make<ast::Variable>(&var),
+				expression,
 				ast::BinaryOperator::Assign
 			)
 		);
 	}
 
-	auto Parser::block() -> std::unique_ptr<ast::Block>
+	// Operands go on the operands stack, operators wait on the operators stack until one that binds
+	// less tightly shows up. Parentheses and calls leave a marker there and are closed by ')'.
+	// Which tokens are operators and how tight they bind comes from operatorRules.
+	template<TokenSource Source>
+	auto Parser<Source>::expr() -> ast::Expression*
 	{
-		ScopeGuard guard{builder};
-		consume(Token::Type::OCBracket);
-		ast::Block blck;
-		
-		while(!match(Token::Type::CCBracket))
-		{
-			blck.stmts.push_back(stmt());
-		}
-		consume(Token::Type::CCBracket);
-		return std::make_unique<ast::Block>(std::move(blck));
-	}
+		auto base = operators.size();
+		auto baseOperands = operands.size();
+		std::size_t open = 0;
 
-	auto Parser::unaryExpr() -> std::unique_ptr<ast::Expression>
-	{
-		if(match(Token::Type::Not))
+		// Applies the operators above the innermost marker that bind at least as tight as power
+		auto reduce = [&](int power, Associativity assoc)
 		{
-			advance();
-			return std::make_unique<ast::UnaryExpression>(primaryExpr(), ast::UnaryOperator::Not);
-		}
-		else
+			while(operators.size() > base && operators.back().kind <= Operator::Kind::Infix)
+			{
+				auto& top = operators.back();
+				if(top.power < power || (top.power == power && assoc == Associativity::Right))
+				{
+					break;
+				}
+				if(top.kind == Operator::Kind::Prefix)
+				{
+					operands.back() = arena.make<ast::UnaryExpression>(operands.back(), top.unary);
+				}
+				else
+				{
+					auto right = operands.back();
+					operands.pop_back();
+					operands.back() = arena.make<ast::BinaryExpression>(operands.back(), right, top.binary);
+				}
+				operators.pop_back();
+			}
+		};
+
+		while(true)
 		{
-			return primaryExpr();
+			// Operand, possibly preceded by prefix operators
+			if(auto& rule = operatorRules[next.type]; rule.prefixPower != 0)
+			{
+				operators.push_back({Operator::Kind::Prefix, rule.prefixPower, rule.unary});
+				advance();
+				continue;
+			}
+			switch(next.type)
+			{
+				case Token::Type::OParen:
+					nest(frames.size() + open++);
+					advance();
+					operators.push_back({Operator::Kind::Paren});
+					continue;
+				case Token::Type::Id:
+				{
+					//Check if function call or variable
+					auto name = consume(Token::Type::Id);
+					if(match(Token::Type::OParen))
+					{
+						nest(frames.size() + open++);
+						advance();
+						operators.push_back({Operator::Kind::Call, 0, {}, {}, &resolve<SymbolTable::Function>(name), pendingArgs.size()});
+						if(!match(Token::Type::CParen))
+						{
+							continue;
+						}
+						// No arguments, the ')' is handled below
+						operands.push_back(nullptr);
+					}
+					else
+					{
+						operands.push_back(arena.make<ast::Variable>(&resolve<SymbolTable::Variable>(name)));
+					}
+					break;
+				}
+				default:
+					operands.push_back(constant());
+					break;
+			}
+
+			// Closing parentheses and calls, then an infix operator or the end of the expression
+			while(true)
+			{
+				if(auto& rule = operatorRules[next.type]; rule.infixPower != 0)
+				{
+					reduce(rule.infixPower, rule.assoc);
+					operators.push_back({Operator::Kind::Infix, rule.infixPower, {}, rule.binary});
+					advance();
+					break;
+				}
+
+				reduce(0, Associativity::Left);
+				if(open == 0)
+				{
+					auto expression = operands.back();
+					operands.resize(baseOperands);
+					return expression;
+				}
+
+				auto& marker = operators.back();
+				if(marker.kind == Operator::Kind::Call && match(Token::Type::Comma, Token::Type::CParen))
+				{
+					if(operands.back() != nullptr)
+					{
+						pendingArgs.push_back(operands.back());
+					}
+					operands.pop_back();
+					if(match(Token::Type::Comma))
+					{
+						advance();
+						break;
+					}
+					auto arguments = arena.copy(std::span<ast::Expression* const>{pendingArgs}.subspan(marker.firstArg));
+					pendingArgs.resize(marker.firstArg);
+					operands.push_back(arena.make<ast::Call>(marker.function, arguments));
+				}
+				consume(Token::Type::CParen);
+				operators.pop_back();
+				open--;
+			}
 		}
 	}
 
-	auto Parser::primaryExpr() -> std::unique_ptr<ast::Expression>
+	template<TokenSource Source>
+	auto Parser<Source>::constant() -> ast::Expression*
 	{
 		switch(next.type)
 		{
-			case Token::Type::OParen:
-			{
-				advance();
-				auto expression = expr();
-				consume(Token::Type::CParen);
-				return std::move(expression);
-			}
 			case Token::Type::IntLit:
 			{
-				int n = std::stoi(next.lexem);
+				if(next.intValue > std::numeric_limits<int>::max())
+				{
+					throw CompileError("Integer literal out of range for int: " + std::string{text(next)}, next.offset);
+				}
+				int n = static_cast<int>(next.intValue);
 				advance();
-				return std::make_unique<ast::Constant<int>>(n);
+				return arena.make<ast::Constant<int>>(n);
 			}
 			case Token::Type::FloatLit:
 			{
-				int n = std::stof(next.lexem);
+				double n = next.floatValue;
 				advance();
-				return std::make_unique<ast::Constant<double>>(n);
+				return arena.make<ast::Constant<double>>(n);
 			}
 			case Token::Type::StrLit:
 			{
-				auto str = std::move(next.lexem);
+				auto str = arena.copy(text(next));
 				advance();
-				return std::make_unique<ast::Constant<std::string>>(std::move(str));
-			}
-			case Token::Type::Id:
-			{
-				//Check if function call or variable
-				auto name = consume(Token::Type::Id).lexem;
-
-				if(match(Token::Type::OParen))
-				{
-					advance();
-					std::vector<std::unique_ptr<ast::Expression>> arguments;
-					while(!match(Token::Type::CParen))
-					{
-						arguments.push_back(expr());
-						if(match(Token::Type::Comma))
-						{
-							advance();
-						}
-					}	
-					consume(Token::Type::CParen);
-
-					return std::make_unique<ast::Call>(&builder.top()->get<SymbolTable::Function>(name), std::move(arguments));
-				}
-				else
-				{
-					return std::make_unique<ast::Variable>(&builder.top()->get<SymbolTable::Variable>(name));
-				}
+				return arena.make<ast::Constant<std::string_view>>(str);
 			}
-
 			case Token::Type::True:
 			{
 				advance();
-				return std::make_unique<ast::Constant<bool>>(true);
+				return arena.make<ast::Constant<bool>>(true);
 			}
-
 			case Token::Type::False:
 			{
 				advance();
-				return std::make_unique<ast::Constant<bool>>(false);
+				return arena.make<ast::Constant<bool>>(false);
 			}
 			default:
-				throw std::runtime_error("Unexpected Token");
+				throw CompileError("Unexpected Token", next.offset);
 		}
 	}
 
-	auto Parser::expr() -> std::unique_ptr<ast::Expression>
-	{
-		return binaryExpr();
-	}
 
-	auto Parser::binaryExpr() -> std::unique_ptr<ast::Expression>
-	{
-		return binaryExpr_h(primaryExpr(), 0);
-	}
-
-	auto Parser::binaryExpr_h(std::unique_ptr<ast::Expression> left, int min_precedence) -> std::unique_ptr<ast::Expression>
-	{
-		while(isBinaryOperator(next.type))
-		{
-			auto op_left = tokenToBinOp(next.type);
-			auto prec_left = operatorPrecedence.at(op_left).first;
-			if(prec_left >= min_precedence)
-			{
-				advance();
-				auto right = primaryExpr();
-				while(isBinaryOperator(next.type))
-				{
-					auto op_right = tokenToBinOp(next.type);
-					auto [prec_right, assoc] = operatorPrecedence.at(op_right);
-					if( prec_right > prec_left || assoc == Associativity::Right)
-					{
-						right = binaryExpr_h(std::move(right), prec_left + 1);
-					}
-					else
-					{
-						break;
-					}
-				}
-				left = std::make_unique<ast::BinaryExpression>(std::move(left), std::move(right), op_left);
-			}
-			else
-			{
-				break;
-			}
-		}
-		return std::move(left);
-	}
-}
\ No newline at end of file
+	template class Parser<Lexer::Lexer>;
+	template class Parser<TokenBufferReader>;
+	template class Parser<ProducerSource>;
+}
@@ -0,0 +1,107 @@
+#ifndef cfg_hpp
+#define cfg_hpp
+#include "Tac.hpp"
+#include <span>
+#include <string_view>
+#include <vector>
+#include <limits>
+#include <cstdint>
+
+namespace intermediate_rep::tac
+{
+	// Control flow graph of a tac::Function.
+	// A block is a range of the function's quadruples, it ends after a jump, call or return,
+	// or before a label. Successors are resolved once when the graph is built, so users never
+	// look up labels themselves. Blocks keep their id for the lifetime of the graph, the
+	// quadruples must stay where they are while it is used.
+	class Cfg
+	{
+	public:
+		using BlockId = std::uint32_t;
+
+		static constexpr BlockId noBlock = std::numeric_limits<BlockId>::max();
+
+		struct Block
+		{
+			std::uint32_t begin;	// index of the first quadruple
+			std::uint32_t end;		// one past the last quadruple
+			std::vector<BlockId> successors = {};
+			std::vector<BlockId> predecessors = {};
+			BlockId next = noBlock;	// following block in the code
+			bool removed = false;	// merged into its predecessor
+		};
+
+		explicit Cfg(Function& function);
+
+		// The first block, noBlock for a function without code. Jumps to labels that are
+		// not in the function lead nowhere.
+		BlockId entry() const
+		{
+			return blocks.empty() ? noBlock : 0;
+		}
+
+		// Ids of removed blocks included
+		std::size_t size() const
+		{
+			return blocks.size();
+		}
+
+		const Block& block(BlockId id) const
+		{
+			return blocks[id];
+		}
+
+		std::span<Quadruple> code(BlockId id) const
+		{
+			return std::span<Quadruple>{function.tac}.subspan(blocks[id].begin, blocks[id].end - blocks[id].begin);
+		}
+
+		// Block starting at label, noBlock if there is none
+		BlockId blockOf(std::string_view label) const;
+
+		// Blocks in the order of the code
+		std::vector<BlockId> layout() const;
+
+		// Blocks reachable from the entry
+		std::vector<BlockId> postorder() const;
+		std::vector<BlockId> reversePostorder() const;
+
+		// Ends block before the quadruple at index at, the rest becomes a new block that takes
+		// over the successors. Returns the new block.
+		BlockId split(BlockId id, std::uint32_t at);
+
+		// Appends the next block in the code to block, which must be its only predecessor
+		// and fall through to it without a jump, call or return. Undoes split.
+		void merge(BlockId id);
+
+	private:
+		void addEdge(BlockId from, BlockId to);
+
+		// Replaces from by to in the predecessors of the successors to took over from from
+		void movePredecessors(BlockId from, BlockId to);
+
+		// Slot of the block starting at label, or the empty slot it would go into
+		std::size_t findSlot(std::string_view label) const;
+
+		// Enters the label of the first quadruple of id, if it has one
+		void addLabel(BlockId id);
+
+		void grow();
+
+		std::string_view labelOf(BlockId id) const
+		{
+			return function.tac[blocks[id].begin].label;
+		}
+
+		Function& function;
+		std::vector<Block> blocks;
+		// Open addressing with linear probing over the labels, slots hold block ids.
+		// The labels are not copied, a slot compares with the first quadruple of its block.
+		// A label defined twice resolves to its first block. Merged blocks keep their slot,
+		// a later split at their label takes it over again.
+		std::vector<BlockId> slots;
+		std::size_t labelCount = 0;
+	};
+}
+
+#endif
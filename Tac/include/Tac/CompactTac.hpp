@@ -0,0 +1,89 @@
+#ifndef compact_tac_hpp
+#define compact_tac_hpp
+#include "Tac.hpp"
+#include "Ast/SymbolTable.hpp"
+#include <string>
+#include <ostream>
+#include <vector>
+#include <limits>
+#include <cstdint>
+
+namespace intermediate_rep::tac
+{
+	// Compact encoding of the TAC of a function.
+	// Instructions are 20 bytes without heap memory of their own: labels are numbered, operands
+	// are tagged 32 bit references into pools of the function. Variables and functions are the
+	// ones of the Quadruples the code was made from, they are not owned by the CompactFunction.
+
+	class Operand
+	{
+	public:
+		enum class Kind : std::uint8_t
+		{
+			None, Variable, Function, Int, Double, Bool, Label, CallArgNum
+		};
+
+		static constexpr unsigned kindBits = 3;
+		static constexpr std::uint32_t maxIndex = (std::uint32_t{1} << (32 - kindBits)) - 1;
+
+		Operand() = default;
+
+		Operand(Kind kind, std::uint32_t index):
+			bits{(index << kindBits) | static_cast<std::uint32_t>(kind)}
+		{}
+
+		Kind kind() const
+		{
+			return static_cast<Kind>(bits & ((1u << kindBits) - 1));
+		}
+
+		// Pool index, or the value itself for Bool and CallArgNum
+		std::uint32_t index() const
+		{
+			return bits >> kindBits;
+		}
+
+	private:
+		std::uint32_t bits = 0;
+	};
+
+	inline constexpr std::uint32_t noLabel = std::numeric_limits<std::uint32_t>::max();
+
+	struct Instruction
+	{
+		std::uint32_t label;	// into CompactFunction::labels, noLabel for none
+		Operand result;
+		Operand arg1;
+		Operand arg2;
+		InstructionType instr;
+	};
+
+	static_assert(sizeof(Instruction) <= 20, "Instructions are meant to stay small");
+
+	struct CompactFunction
+	{
+		intermediate_rep::SymbolTable::Function* sym_entry;
+		std::vector<Instruction> code = {};
+
+		// Operand pools, every entry appears once
+		std::vector<intermediate_rep::SymbolTable::Variable*> variables = {};
+		std::vector<intermediate_rep::SymbolTable::Function*> functions = {};
+		std::vector<int> ints = {};
+		std::vector<double> doubles = {};
+		// Names of the labels, only needed for listings and to convert back
+		std::vector<Label> labels = {};
+
+		// Quadruple at index, labels are spelled out again
+		Quadruple quadruple(std::size_t index) const;
+	};
+
+	// Throws std::length_error if a pool of function outgrows the operand index
+	CompactFunction compact(const Function& function);
+
+	std::vector<Quadruple> expand(const CompactFunction& function);
+
+	// Same listing as for the Function the code was made from
+	std::ostream& operator<<(std::ostream& os, const CompactFunction& function);
+}
+
+#endif
@@ -3,7 +3,11 @@
 #include <variant>
 #include "Ast/SymbolTable.hpp"
 #include <string>
+#include <string_view>
 #include <ostream>
+#include <vector>
+#include <memory>
+#include <cstdint>
 
 namespace intermediate_rep::tac
 {
@@ -37,7 +41,7 @@ namespace intermediate_rep::tac
 
 	*/
 
-	enum class InstructionType
+	enum class InstructionType : std::uint8_t
 	{
 		Add,
 		Sub,
@@ -91,8 +95,8 @@ namespace intermediate_rep::tac
 		Label label;
 		InstructionType instr;
 		Address result;
-		Address arg1;
-		Address arg2;
+		Address arg1 = {};
+		Address arg2 = {};
 	};
 
 	std::ostream& operator<<(std::ostream& os, const Quadruple& quad);
@@ -100,11 +104,24 @@ namespace intermediate_rep::tac
 	struct Function
 	{
 		intermediate_rep::SymbolTable::Function* sym_entry;
-		std::vector<Quadruple> tac;
+		std::vector<Quadruple> tac = {};
+		// Every variable the function uses, at its Variable::index
+		std::vector<intermediate_rep::SymbolTable::Variable*> variables = {};
+		// Virtual registers for intermediate results, boxed so their addresses survive moves
+		std::vector<std::unique_ptr<intermediate_rep::SymbolTable::Variable>> temporaries = {};
 	};
 
+	// Name of var in listings, temporaries have no name of their own and show up as __tempN
+	std::string nameOf(const intermediate_rep::SymbolTable::Variable& var);
+
+	// Gives the variables of function dense indices: parameters first, then in order of first use
+	void numberVariables(Function& function);
+
 	std::ostream& operator<<(std::ostream& os, const Function& function);
 
+	// Title and column heads of a function listing
+	std::ostream& printListingHeader(std::ostream& os, std::string_view functionName);
+
 }
 
 
@@ -0,0 +1,226 @@
+#include "Cfg.hpp"
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+
+namespace intermediate_rep::tac
+{
+	Cfg::Cfg(Function& function):
+		function{function}
+	{
+		auto size = static_cast<std::uint32_t>(function.tac.size());
+		std::uint32_t begin = 0;
+		std::size_t blockCount = 0;
+		for(std::uint32_t i = 0; i < size; ++i)
+		{
+			blockCount += i == 0 || isJump(function.tac[i - 1].instr) || !function.tac[i].label.empty();
+		}
+		blocks.reserve(blockCount);
+		slots.assign(std::bit_ceil(std::max<std::size_t>(8, blockCount * 2)), noBlock);
+		while(begin < size)
+		{
+			auto end = begin + 1;
+			while(end < size && !isJump(function.tac[end - 1].instr) && function.tac[end].label.empty())
+			{
+				++end;
+			}
+
+			auto id = static_cast<BlockId>(blocks.size());
+			if(id != 0)
+			{
+				blocks.back().next = id;
+			}
+			blocks.push_back(Block{begin, end});
+			addLabel(id);
+			begin = end;
+		}
+
+		for(BlockId id = 0; id < blocks.size(); ++id)
+		{
+			auto& last = function.tac[blocks[id].end - 1];
+			using enum InstructionType;
+			if(last.instr == Jump || last.instr == IfJump || last.instr == IfFalseJump)
+			{
+				// Labels that were never placed give no edge
+				auto label = std::get_if<Label>(&last.result);
+				auto target = label == nullptr ? noBlock : blockOf(*label);
+				if(target != noBlock)
+				{
+					addEdge(id, target);
+				}
+			}
+			if(last.instr != Jump && last.instr != Return && blocks[id].next != noBlock)
+			{
+				addEdge(id, blocks[id].next);
+			}
+		}
+	}
+
+	Cfg::BlockId Cfg::blockOf(std::string_view label) const
+	{
+		auto id = slots[findSlot(label)];
+		return id == noBlock || blocks[id].removed ? noBlock : id;
+	}
+
+	std::vector<Cfg::BlockId> Cfg::layout() const
+	{
+		std::vector<BlockId> order;
+		for(auto id = entry(); id != noBlock; id = blocks[id].next)
+		{
+			order.push_back(id);
+		}
+		return order;
+	}
+
+	std::vector<Cfg::BlockId> Cfg::postorder() const
+	{
+		std::vector<BlockId> order;
+		if(blocks.empty())
+		{
+			return order;
+		}
+
+		// Block and the number of its successors visited so far
+		std::vector<std::pair<BlockId, std::size_t>> stack{{entry(), 0}};
+		std::vector<bool> visited(blocks.size());
+		visited[entry()] = true;
+		while(!stack.empty())
+		{
+			auto& [id, next] = stack.back();
+			auto& successors = blocks[id].successors;
+			if(next == successors.size())
+			{
+				order.push_back(id);
+				stack.pop_back();
+				continue;
+			}
+			auto successor = successors[next++];
+			if(!visited[successor])
+			{
+				visited[successor] = true;
+				stack.emplace_back(successor, 0);
+			}
+		}
+		return order;
+	}
+
+	std::vector<Cfg::BlockId> Cfg::reversePostorder() const
+	{
+		auto order = postorder();
+		std::reverse(order.begin(), order.end());
+		return order;
+	}
+
+	Cfg::BlockId Cfg::split(BlockId id, std::uint32_t at)
+	{
+		if(at <= blocks[id].begin || at >= blocks[id].end)
+		{
+			throw std::runtime_error("Split outside of the block");
+		}
+
+		auto tail = static_cast<BlockId>(blocks.size());
+		auto& block = blocks.emplace_back(Block{at, blocks[id].end});
+		auto& head = blocks[id];
+		block.successors = std::move(head.successors);
+		block.next = head.next;
+		head.successors.clear();
+		head.end = at;
+		head.next = tail;
+		addLabel(tail);
+
+		movePredecessors(id, tail);
+		addEdge(id, tail);
+		return tail;
+	}
+
+	void Cfg::merge(BlockId id)
+	{
+		auto& head = blocks[id];
+		auto tailId = head.next;
+		if(tailId == noBlock || isJump(function.tac[head.end - 1].instr)
+			|| blocks[tailId].predecessors.size() != 1)
+		{
+			throw std::runtime_error("Blocks can not be merged");
+		}
+
+		auto& tail = blocks[tailId];
+		head.end = tail.end;
+		head.next = tail.next;
+		head.successors = std::move(tail.successors);
+		movePredecessors(tailId, id);
+
+		tail = Block{tail.begin, tail.begin};
+		tail.removed = true;
+	}
+
+	std::size_t Cfg::findSlot(std::string_view label) const
+	{
+		auto mask = slots.size() - 1;
+		for(auto slot = std::hash<std::string_view>{}(label) & mask;; slot = (slot + 1) & mask)
+		{
+			if(slots[slot] == noBlock || labelOf(slots[slot]) == label)
+			{
+				return slot;
+			}
+		}
+	}
+
+	void Cfg::addLabel(BlockId id)
+	{
+		auto label = labelOf(id);
+		if(label.empty())
+		{
+			return;
+		}
+		// The first block that defines a label keeps it, only a merged block gives it up
+		auto slot = findSlot(label);
+		if(slots[slot] != noBlock && !blocks[slots[slot]].removed)
+		{
+			return;
+		}
+		if(slots[slot] == noBlock)
+		{
+			if((labelCount + 1) * 2 > slots.size())
+			{
+				grow();
+				slot = findSlot(label);
+			}
+			++labelCount;
+		}
+		slots[slot] = id;
+	}
+
+	void Cfg::grow()
+	{
+		std::vector<BlockId> old(slots.size() * 2, noBlock);
+		old.swap(slots);
+		for(auto id : old)
+		{
+			if(id != noBlock)
+			{
+				slots[findSlot(labelOf(id))] = id;
+			}
+		}
+	}
+
+	void Cfg::addEdge(BlockId from, BlockId to)
+	{
+		auto& successors = blocks[from].successors;
+		if(std::find(successors.begin(), successors.end(), to) == successors.end())
+		{
+			successors.push_back(to);
+			blocks[to].predecessors.push_back(from);
+		}
+	}
+
+	void Cfg::movePredecessors(BlockId from, BlockId to)
+	{
+		for(auto successor : blocks[to].successors)
+		{
+			auto& predecessors = blocks[successor].predecessors;
+			std::replace(predecessors.begin(), predecessors.end(), from, to);
+		}
+	}
+}
@@ -0,0 +1,167 @@
+#include "CompactTac.hpp"
+#include <bit>
+#include <iomanip>
+#include <stdexcept>
+#include <unordered_map>
+#include <variant>
+
+namespace intermediate_rep::tac
+{
+	namespace
+	{
+		using Variable = intermediate_rep::SymbolTable::Variable;
+		using SymFunction = intermediate_rep::SymbolTable::Function;
+
+		// Gives every distinct value of a pool one index
+		template<typename T, typename Key = T>
+		struct Pool
+		{
+			std::vector<T>& values;
+			std::unordered_map<Key, std::uint32_t> index = {};
+
+			std::uint32_t operator()(const T& value, const Key& key)
+			{
+				auto [iter, inserted] = index.try_emplace(key, static_cast<std::uint32_t>(values.size()));
+				if(inserted)
+				{
+					if(values.size() > Operand::maxIndex)
+					{
+						throw std::length_error("Too many operands for the compact TAC");
+					}
+					values.push_back(value);
+				}
+				return iter->second;
+			}
+
+			std::uint32_t operator()(const T& value)
+			{
+				return (*this)(value, value);
+			}
+		};
+
+		struct Encoder
+		{
+			Pool<Variable*> variables;
+			Pool<SymFunction*> functions;
+			Pool<int> ints;
+			// Keyed by the bits, so -0.0 and 0.0 stay apart
+			Pool<double, std::uint64_t> doubles;
+			Pool<Label> labels;
+
+			auto operator()(const std::monostate&) -> Operand
+			{
+				return {};
+			}
+			auto operator()(Variable* var) -> Operand
+			{
+				return {Operand::Kind::Variable, variables(var)};
+			}
+			auto operator()(SymFunction* func) -> Operand
+			{
+				return {Operand::Kind::Function, functions(func)};
+			}
+			auto operator()(const Constant<int>& c) -> Operand
+			{
+				return {Operand::Kind::Int, ints(c.value)};
+			}
+			auto operator()(const Constant<double>& c) -> Operand
+			{
+				return {Operand::Kind::Double, doubles(c.value, std::bit_cast<std::uint64_t>(c.value))};
+			}
+			auto operator()(const Constant<bool>& c) -> Operand
+			{
+				return {Operand::Kind::Bool, c.value ? 1u : 0u};
+			}
+			auto operator()(const Label& label) -> Operand
+			{
+				return {Operand::Kind::Label, labels(label)};
+			}
+			auto operator()(const CallArgNum& num) -> Operand
+			{
+				if(num.size > Operand::maxIndex)
+				{
+					throw std::length_error("Too many call arguments for the compact TAC");
+				}
+				return {Operand::Kind::CallArgNum, static_cast<std::uint32_t>(num.size)};
+			}
+		};
+
+		Address decode(const CompactFunction& function, Operand operand)
+		{
+			auto index = operand.index();
+			switch(operand.kind())
+			{
+				case Operand::Kind::None:
+					return std::monostate{};
+				case Operand::Kind::Variable:
+					return function.variables[index];
+				case Operand::Kind::Function:
+					return function.functions[index];
+				case Operand::Kind::Int:
+					return Constant<int>{function.ints[index]};
+				case Operand::Kind::Double:
+					return Constant<double>{function.doubles[index]};
+				case Operand::Kind::Bool:
+					return Constant<bool>{index != 0};
+				case Operand::Kind::Label:
+					return function.labels[index];
+				case Operand::Kind::CallArgNum:
+					return CallArgNum{index};
+			}
+			throw std::runtime_error("Invalid operand kind");
+		}
+	}
+
+	Quadruple CompactFunction::quadruple(std::size_t index) const
+	{
+		auto& instruction = code[index];
+		return {
+			instruction.label == noLabel ? Label{} : labels[instruction.label],
+			instruction.instr,
+			decode(*this, instruction.result),
+			decode(*this, instruction.arg1),
+			decode(*this, instruction.arg2),
+		};
+	}
+
+	CompactFunction compact(const Function& function)
+	{
+		CompactFunction result{function.sym_entry};
+		result.code.reserve(function.tac.size());
+		Encoder encoder{{result.variables}, {result.functions}, {result.ints}, {result.doubles}, {result.labels}};
+
+		for(auto& quad : function.tac)
+		{
+			result.code.push_back({
+				quad.label.empty() ? noLabel : encoder.labels(quad.label),
+				std::visit(encoder, quad.result),
+				std::visit(encoder, quad.arg1),
+				std::visit(encoder, quad.arg2),
+				quad.instr,
+			});
+		}
+		return result;
+	}
+
+	std::vector<Quadruple> expand(const CompactFunction& function)
+	{
+		std::vector<Quadruple> tac;
+		tac.reserve(function.code.size());
+		for(std::size_t i = 0; i < function.code.size(); ++i)
+		{
+			tac.push_back(function.quadruple(i));
+		}
+		return tac;
+	}
+
+	std::ostream& operator<<(std::ostream& os, const CompactFunction& function)
+	{
+		printListingHeader(os, function.sym_entry->name);
+
+		for(std::size_t i = 0; i < function.code.size(); ++i)
+		{
+			os << std::setw(15) << ("(" + std::to_string(i) + ")") << function.quadruple(i) << '\n';
+		}
+		return os;
+	}
+}
@@ -39,12 +39,12 @@ namespace intermediate_rep::tac
 
 		auto operator()(intermediate_rep::SymbolTable::Variable* const & var) -> std::string
 		{
-			return var->name;
+			return nameOf(*var);
 		}
 
 		auto operator()(intermediate_rep::SymbolTable::Function* const& fun) -> std::string
 		{
-			return fun->name;
+			return std::string{fun->name};
 		}
 
 		template<typename T>
@@ -77,15 +77,20 @@ namespace intermediate_rep::tac
 		return os << " ]";;
 	}
 
-	std::ostream& operator<<(std::ostream& os, const Function& function)
+	std::ostream& printListingHeader(std::ostream& os, std::string_view functionName)
 	{
 		os << std::left;
-		os << "Function " << function.sym_entry->name << ":\n";
+		os << "Function " << functionName << ":\n";
 		os << "[ " << std::setw(15)  << "Index" <<std::setw(15) << "Label"  << std::setw(15) <<
 		 "Instruction" << std::setw(15) << "Result" << std::setw(15) << "Arg1" << std::setw(15) << "Arg2" << " ]\n";
 		for(int i = 0; i < 15 * 6 + 4; ++i)
 			os << '#';
-		os << '\n';
+		return os << '\n';
+	}
+
+	std::ostream& operator<<(std::ostream& os, const Function& function)
+	{
+		printListingHeader(os, function.sym_entry->name);
 
 		for(int i = 0; i < function.tac.size(); ++i)
 		{
@@ -109,6 +114,44 @@ namespace intermediate_rep::tac
 				return false;
 		}
 	}
-}
 
+	std::string nameOf(const intermediate_rep::SymbolTable::Variable& var)
+	{
+		if(var.isTemp)
+		{
+			return "__temp" + std::to_string(var.id);
+		}
+		return std::string{var.name};
+	}
+
+	void numberVariables(Function& function)
+	{
+		using Variable = intermediate_rep::SymbolTable::Variable;
 
+		function.variables.clear();
+		auto number = [&](Variable* var)
+		{
+			if(var->index < function.variables.size() && function.variables[var->index] == var)
+			{
+				return;
+			}
+			var->index = static_cast<std::uint32_t>(function.variables.size());
+			function.variables.push_back(var);
+		};
+
+		for(auto param : function.sym_entry->parameters)
+		{
+			number(param);
+		}
+		for(auto& quad : function.tac)
+		{
+			for(auto address : {&quad.result, &quad.arg1, &quad.arg2})
+			{
+				if(auto var = std::get_if<Variable*>(address))
+				{
+					number(*var);
+				}
+			}
+		}
+	}
+}
@@ -1,6 +1,7 @@
 #ifndef tacgenerator_hpp
 #define tacgenerator_hpp
 #include "Ast/Ast.hpp"
+#include "Ast/FlatAst.hpp"
 #include "Tac/Tac.hpp"
 #include <vector>
 
@@ -9,12 +10,16 @@ namespace tac_gen
 	class TacGenerator
 	{
 	public:
+		// Generates from the flat form of the program, see ast::flatten
 		TacGenerator(intermediate_rep::ast::Program* ast);
 
+		TacGenerator(const intermediate_rep::ast::FlatAst* ast);
+
 		auto gen() -> std::vector<intermediate_rep::tac::Function>;
 
 	private:
-		intermediate_rep::ast::Program* ast;
+		intermediate_rep::ast::Program* program = nullptr;
+		const intermediate_rep::ast::FlatAst* flat = nullptr;
 	};
 
 }
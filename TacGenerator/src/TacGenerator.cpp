@@ -3,6 +3,9 @@
 #include <functional>
 #include <stack>
 #include <stdexcept>
+#include <utility>
+#include <cstdint>
+#include <memory>
 
 namespace tac_gen
 {
@@ -64,7 +67,11 @@ namespace tac_gen
 	}
 
 	TacGenerator::TacGenerator(ast::Program* ast):
-		ast{ast}
+		program{ast}
+	{}
+
+	TacGenerator::TacGenerator(const ast::FlatAst* ast):
+		flat{ast}
 	{}
 
 	auto TacGenerator::gen() -> std::vector<tac::Function>
@@ -87,177 +94,279 @@ namespace tac_gen
 			std::string prefix;
 		};
 
-		struct Visitor : ast::StmtVisitor<std::string, std::string>, ast::ExprVisitor<std::string, std::string>
+		// Walks the flat AST of one function
+		struct Generator
 		{
-
+			const ast::FlatAst& ast;
 			NameGenerator& labelGen;
-			NameGenerator& varNameGen;
-			intermediate_rep::SymbolTable* sym_table;
+			// Temporaries get numbers unique in the program
+			std::uint32_t& tempCount;
+			std::vector<std::unique_ptr<intermediate_rep::SymbolTable::Variable>>& temporaries;
 			std::vector<tac::Quadruple> tac;
-			tac::Address address;
+			// Values of the expressions translated but not yet used by their parent
+			std::vector<tac::Address> values;
+			// Label of the next instruction, a jump target that has not been placed yet
+			tac::Label pending;
 
-			Visitor(NameGenerator& labelGen,NameGenerator& varNameGen, intermediate_rep::SymbolTable* sym_table):
-				labelGen{labelGen}, varNameGen{varNameGen}, sym_table{sym_table}
+			Generator(const ast::FlatAst& ast, NameGenerator& labelGen, std::uint32_t& tempCount, std::vector<std::unique_ptr<intermediate_rep::SymbolTable::Variable>>& temporaries):
+				ast{ast}, labelGen{labelGen}, tempCount{tempCount}, temporaries{temporaries}
 			{}
 
-			std::string visit(ast::ExprStmt& stmt, std::string label)
+			intermediate_rep::SymbolTable::Variable* newTemp(intermediate_rep::SymbolTable::Variable::Type type)
 			{
-				label = stmt.expr->accept(*this, label);
-				return label;
+				auto& temp = temporaries.emplace_back(std::make_unique<intermediate_rep::SymbolTable::Variable>(intermediate_rep::SymbolTable::Variable{tempCount++, {}, type}));
+				temp->isTemp = true;
+				return temp.get();
 			}
 
-			std::string visit(ast::IfStmt& stmt, std::string label)
-			{	
-				stmt.condition->accept(*this, label);
-				auto afterLabel = labelGen.getUniqueLabel();
-
-				if(stmt.falseStmt)
-				{
-					auto falseStmtLabel = labelGen.getUniqueLabel();
-					tac.push_back(tac::Quadruple{"",tac::InstructionType::IfFalseJump, falseStmtLabel, address});
-					stmt.trueStmt->accept(*this, "");
-					tac.push_back(tac::Quadruple{"",tac::InstructionType::Jump, afterLabel});
-					stmt.falseStmt->accept(*this, falseStmtLabel);
-				}
-				else
-				{
-					tac.push_back(tac::Quadruple{"", tac::InstructionType::IfFalseJump, afterLabel, address});
-					stmt.trueStmt->accept(*this, "");
-				}
-				return afterLabel;
+			// Takes the label waiting for the next instruction, leaves none behind
+			tac::Label take()
+			{
+				return std::exchange(pending, {});
 			}
 
-			std::string visit(ast::WhileStmt& stmt, std::string label)
-			{	
-				if (label.empty())
+			// Labels the next instruction. A label already waiting for it gets a jump of its own
+			// instead, an instruction carries one label only.
+			void place(tac::Label label)
+			{
+				if(!pending.empty())
 				{
-					label = labelGen.getUniqueLabel();
+					tac.push_back(tac::Quadruple{take(), tac::InstructionType::Jump, label});
 				}
-				auto afterLabel = labelGen.getUniqueLabel();
-				label = stmt.condition->accept(*this, label);
-				tac.push_back(tac::Quadruple{label, tac::InstructionType::IfFalseJump, afterLabel, address});
-				stmt.stmt->accept(*this,"");
-				tac.push_back(tac::Quadruple{"", tac::InstructionType::Jump, label});
-				return afterLabel;
+				pending = std::move(label);
 			}
 
-			std::string visit(ast::ReturnStmt& stmt, std::string label) 
+			// Node being translated and how far, its children are translated in between
+			struct Frame
 			{
-				if(stmt.expr)
+				ast::NodeId id;
+				std::uint32_t step = 0;
+				tac::Label label = {};
+				tac::Label afterLabel = {};
+			};
+
+			// Walks with an explicit stack of frames instead of recursing, so deeply nested
+			// programs cost heap memory instead of native stack
+			void run(ast::NodeId root)
+			{
+				std::vector<Frame> frames{{root}};
+				while(!frames.empty())
 				{
-					label = stmt.expr->accept(*this, label);
+					auto child = resume(frames.back());
+					if(child == ast::noNode)
+					{
+						frames.pop_back();
+					}
+					else
+					{
+						frames.push_back({child});
+					}
 				}
-				tac.push_back(tac::Quadruple{ label, tac::InstructionType::Return,std::monostate{},stmt.expr ?
-					 address: tac::Address{std::monostate{}}});
-
-				return "";
 			}
 
-			std::string visit(ast::Block& block, std::string label) 
-			//Could be the block of a function definition block or an enclosing block
+			// Continues frame, returns the child to translate before it goes on,
+			// or noNode once the node is done. Expressions leave their value in values.
+			ast::NodeId resume(Frame& frame)
 			{
-				if(block.stmts.size() != 0)
+				auto& node = ast[frame.id];
+				switch(node.kind)
 				{
-					for(auto& stmt : block.stmts)
+					case ast::NodeKind::ExprStmt:
+						if(frame.step++ == 0)
+						{
+							return node.a;
+						}
+						values.pop_back();
+						return ast::noNode;
+
+					case ast::NodeKind::If:
+						switch(frame.step)
+						{
+							case 0:
+								frame.step = 1;
+								return node.a;
+							case 1:
+							{
+								auto condition = pop();
+								frame.afterLabel = labelGen.getUniqueLabel();
+								frame.step = 3;
+								if(node.c != ast::noNode)
+								{
+									frame.label = labelGen.getUniqueLabel();
+									tac.push_back(tac::Quadruple{take(),tac::InstructionType::IfFalseJump, frame.label, condition});
+									frame.step = 2;
+								}
+								else
+								{
+									tac.push_back(tac::Quadruple{take(), tac::InstructionType::IfFalseJump, frame.afterLabel, condition});
+								}
+								return node.b;
+							}
+							case 2:
+								tac.push_back(tac::Quadruple{take(),tac::InstructionType::Jump, frame.afterLabel});
+								pending = std::move(frame.label);
+								frame.step = 3;
+								return node.c;
+							default:
+								place(std::move(frame.afterLabel));
+								return ast::noNode;
+						}
+
+					case ast::NodeKind::While:
+						switch(frame.step)
+						{
+							case 0:
+								if (pending.empty())
+								{
+									pending = labelGen.getUniqueLabel();
+								}
+								frame.label = pending;
+								frame.afterLabel = labelGen.getUniqueLabel();
+								frame.step = 1;
+								return node.a;
+							case 1:
+							{
+								auto condition = pop();
+								tac.push_back(tac::Quadruple{take(), tac::InstructionType::IfFalseJump, frame.afterLabel, condition});
+								frame.step = 2;
+								return node.b;
+							}
+							default:
+								tac.push_back(tac::Quadruple{take(), tac::InstructionType::Jump, std::move(frame.label)});
+								place(std::move(frame.afterLabel));
+								return ast::noNode;
+						}
+
+					case ast::NodeKind::Return:
+						if(frame.step++ == 0 && node.a != ast::noNode)
+						{
+							return node.a;
+						}
+						tac.push_back(tac::Quadruple{ take(), tac::InstructionType::Return,std::monostate{},node.a != ast::noNode ?
+							 pop(): tac::Address{std::monostate{}}});
+						return ast::noNode;
+
+					//Could be the block of a function definition block or an enclosing block
+					case ast::NodeKind::Block:
 					{
-						label = stmt->accept(*this, label);
+						auto children = ast.children(node);
+						return frame.step < children.size() ? children[frame.step++] : ast::noNode;
 					}
-				}
-				return label;
-			}
 
-			intermediate_rep::SymbolTable::Variable* newTemp(intermediate_rep::SymbolTable::Variable::Type type)
-			{
-				auto name = varNameGen.getUniqueLabel();
-				return &sym_table->insert(name, intermediate_rep::SymbolTable::Variable{name, type});
-			}
+					case ast::NodeKind::Binary:
+					{
+						if(frame.step < 2)
+						{
+							return frame.step++ == 0 ? node.a : node.b;
+						}
+						auto op = static_cast<ast::BinaryOperator>(node.op);
+						auto right = pop();
+						auto left = pop();
+
+						if(op == ast::BinaryOperator::Assign)
+						{
+							values.push_back(left);
+							tac.push_back({take(), binaryOpToInstruction(op), left, right});
+						}
+						else
+						{
+							auto varPtr = newTemp(node.type);
+							values.push_back(varPtr);
+							tac.push_back({take(), binaryOpToInstruction(op), varPtr, left, right});
+						}
+						return ast::noNode;
+					}
 
-			std::string visit(ast::BinaryExpression& expr, std::string label)
-			{	
-				label = expr.left->accept(*this, label);
-				auto left = address;
-				label = expr.right->accept(*this, label);
-				auto right = address;
+					case ast::NodeKind::Unary:
+					{
+						if(frame.step++ == 0)
+						{
+							return node.a;
+						}
+						auto operand = pop();
+						auto varPtr = newTemp(node.type);
+						values.push_back(varPtr);
+						tac.push_back({take(), unaryOpToInstruction(static_cast<ast::UnaryOperator>(node.op)), varPtr, operand});
+						return ast::noNode;
+					}
 
-				if(expr.op == ast::BinaryOperator::Assign)
-				{
-					address = left;
-					tac.push_back({label, binaryOpToInstruction(expr.op), left, right});
-				}
-				else
-				{				
-					auto varPtr = newTemp(expr.type);
-					address = varPtr;
-					tac.push_back({label, binaryOpToInstruction(expr.op), varPtr, left, right});
-				}
+					case ast::NodeKind::Call:
+					{
+						// Each argument is passed as soon as it is computed
+						auto args = ast.children(node);
+						if(frame.step > 0)
+						{
+							tac.push_back({ take(), tac::InstructionType::Param, std::monostate{}, pop() });
+						}
+						if(frame.step < args.size())
+						{
+							return args[frame.step++];
+						}
+						auto function = ast.functions[node.a];
+						auto varPtr = newTemp(function->returnType);
+						values.push_back(varPtr);
+						tac.push_back(tac::Quadruple{take(), tac::InstructionType::Call, varPtr, function, tac::CallArgNum{args.size()}});
+						return ast::noNode;
+					}
 
-				return {};
-			}
+					case ast::NodeKind::Variable:
+						values.push_back(ast.variables[node.a]);
+						return ast::noNode;
 
-			std::string visit(ast::UnaryExpression& expr, std::string label) 
-			{
-				label = expr.expr->accept(*this, label);
-				auto operand = address;
-				auto varPtr = newTemp(expr.type);
-				address = varPtr;
-				tac.push_back({label, unaryOpToInstruction(expr.op), varPtr, operand});
-				return {};
-			}
+					case ast::NodeKind::IntConst:
+						values.push_back(tac::Constant<int>{static_cast<int>(node.a)});
+						return ast::noNode;
 
-			std::string visit(ast::Call& call, std::string label) 
-			{
-				for(auto& arg : call.args)
-				{
-					label = arg->accept(*this, label);
-					tac.push_back({ label, tac::InstructionType::Param, std::monostate{}, address });
-				}
-				auto varPtr = newTemp(call.sym_entry->returnType);
-				address = varPtr;
-				tac.push_back(tac::Quadruple{label, tac::InstructionType::Call, varPtr, call.sym_entry, tac::CallArgNum{call.args.size()}});
-				return {};
-			}
+					case ast::NodeKind::FloatConst:
+						values.push_back(tac::Constant<double>{ast.floats[node.a]});
+						return ast::noNode;
 
-			std::string visit(ast::Variable& var, std::string label) 
-			{
-				address = var.sym_entry;
-				return label;
-			}
+					case ast::NodeKind::BoolConst:
+						values.push_back(tac::Constant<bool>{node.a != 0});
+						return ast::noNode;
 
-			std::string visit(ast::Constant<int>& c, std::string label) 
-			{
-				address = tac::Constant<int>{c.value};
-				return label;
-			}
-			
-			std::string visit(ast::Constant<double>& c, std::string label) 
-			{
-				address = tac::Constant<double>{c.value};
-				return label;
-			}
+					case ast::NodeKind::StrConst:
+						// The parser accepts them, but there is no TAC operand for strings yet
+						throw std::runtime_error("String constants can not be translated to TAC");
 
-			std::string visit(ast::Constant<bool>& c, std::string label)
-			{
-				address = tac::Constant<bool>{c.value};
-				return label;
+					default:
+						throw std::runtime_error("Unknown node kind");
+				}
 			}
 
-			std::string visit(ast::Constant<std::string>&, std::string label) 
+			// Value of the expression translated last
+			tac::Address pop()
 			{
-				throw std::runtime_error("");
-			}	
-
+				auto value = std::move(values.back());
+				values.pop_back();
+				return value;
+			}
 		};
 
 		NameGenerator labelGen{"__label"};
-		NameGenerator varNameGen{"__temp"};
+		std::uint32_t tempCount = 0;
 
 		std::vector<tac::Function> functions;
 
-		for(auto& function : ast->functions)
+		auto generate = [&](const ast::FlatAst& flat)
+		{
+			for(auto& function : flat.bodies)
+			{
+				auto& result = functions.emplace_back(tac::Function{function.sym_entry, {}});
+				Generator generator{flat, labelGen, tempCount, result.temporaries};
+				generator.run(function.body);
+				result.tac = std::move(generator.tac);
+				tac::numberVariables(result);
+			}
+		};
+
+		if(program != nullptr)
+		{
+			generate(ast::flatten(*program));
+		}
+		else
 		{
-			Visitor visitor{labelGen, varNameGen, &function.sym_entry->parameter_scope->getChild(0)};
-			function.block->accept(visitor, "");
-			functions.push_back(tac::Function{function.sym_entry, std::move(visitor.tac)});
+			generate(*flat);
 		}
 
 		return functions;
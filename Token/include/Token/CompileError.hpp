@@ -0,0 +1,28 @@
+#ifndef compileerror_hpp
+#define compileerror_hpp
+#include <stdexcept>
+#include <string>
+#include <cstddef>
+
+namespace intermediate_rep
+{
+	// Error in the compiled program at a byte offset into it.
+	// Line and column are only worked out when the error is reported, see Lexer::LineIndex.
+	class CompileError : public std::runtime_error
+	{
+	public:
+		CompileError(const std::string& message, std::size_t offset):
+			std::runtime_error{message}, position{offset}
+		{}
+
+		std::size_t offset() const
+		{
+			return position;
+		}
+
+	private:
+		std::size_t position;
+	};
+}
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef interner_hpp
+#define interner_hpp
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+namespace intermediate_rep
+{
+	// Dense id of an interned identifier
+	using SymbolId = std::uint32_t;
+
+	// Maps every distinct identifier of a compilation to a SymbolId and stores its name once.
+	// Ids are handed out in order of first appearance, name views stay valid as long as the interner lives.
+	// One interner is shared by all stages of a compilation.
+	class Interner
+	{
+	public:
+		Interner();
+
+		Interner(const Interner&) = delete;
+		Interner& operator=(const Interner&) = delete;
+
+		Interner(Interner&&) = default;
+		Interner& operator=(Interner&&) = default;
+
+		SymbolId intern(std::string_view name);
+
+		std::string_view name(SymbolId id) const
+		{
+			return names[id];
+		}
+
+		std::size_t size() const
+		{
+			return names.size();
+		}
+
+	private:
+		std::string_view store(std::string_view name);
+
+		void grow();
+
+		static constexpr SymbolId emptySlot = UINT32_MAX;
+		static constexpr std::size_t blockSize = 64 * 1024;
+
+		// Characters of all names, blocks never move
+		std::vector<std::unique_ptr<char[]>> blocks;
+		std::size_t blockUsed = blockSize;
+
+		std::vector<std::string_view> names;
+		std::vector<std::size_t> hashes;
+
+		// Open addressing with linear probing, slots hold ids
+		std::vector<SymbolId> slots;
+	};
+}
+
+#endif
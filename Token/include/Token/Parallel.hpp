@@ -0,0 +1,51 @@
+#ifndef parallel_hpp
+#define parallel_hpp
+#include <thread>
+#include <vector>
+#include <exception>
+#include <cstddef>
+
+namespace intermediate_rep
+{
+	// Run work(i) for every piece on its own thread, piece 0 on the calling thread.
+	// Rethrows the error of the first failing piece, so errors are the ones a sequential pass reports first.
+	template<typename Work>
+	void forEachPiece(std::size_t pieces, Work work)
+	{
+		std::vector<std::exception_ptr> errors(pieces);
+		{
+			std::vector<std::jthread> workers;
+			for(std::size_t i = 1; i < pieces; ++i)
+			{
+				workers.emplace_back([&work, &errors, i]()
+				{
+					try
+					{
+						work(i);
+					}
+					catch(...)
+					{
+						errors[i] = std::current_exception();
+					}
+				});
+			}
+			try
+			{
+				work(0);
+			}
+			catch(...)
+			{
+				errors[0] = std::current_exception();
+			}
+		}
+		for(auto& error : errors)
+		{
+			if(error)
+			{
+				std::rethrow_exception(error);
+			}
+		}
+	}
+}
+
+#endif
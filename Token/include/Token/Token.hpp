@@ -2,70 +2,155 @@
 #define token_hpp
 
 #include <string>
+#include <string_view>
 #include <iostream>
+#include <cstdint>
+#include <cstddef>
+#include <concepts>
+#include "Interner.hpp"
+
+// Every token type, keywords together with their spelling.
+// Token::Type, tokenTypeToStr and the keyword table of the lexer are generated from this list,
+// adding a keyword only means adding a KEYWORD entry here.
+#define TOKEN_TYPES(KEYWORD, TOKEN) \
+	KEYWORD(True, "true") \
+	KEYWORD(False, "false") \
+	KEYWORD(While, "while") \
+	KEYWORD(If, "if") \
+	KEYWORD(Else, "else") \
+	KEYWORD(Return, "return") \
+	\
+	TOKEN(Id) \
+	TOKEN(IntLit) \
+	TOKEN(FloatLit) \
+	TOKEN(StrLit) \
+	\
+	TOKEN(OParen) \
+	TOKEN(CParen) \
+	TOKEN(OSBracket) \
+	TOKEN(CSBracket) \
+	TOKEN(OCBracket) \
+	TOKEN(CCBracket) \
+	\
+	TOKEN(Comma) \
+	TOKEN(Semicolon) \
+	\
+	TOKEN(Plus) \
+	TOKEN(Minus) \
+	TOKEN(Star) \
+	TOKEN(Slash) \
+	\
+	TOKEN(Less) \
+	TOKEN(LessEqual) \
+	TOKEN(Greater) \
+	TOKEN(GreaterEqual) \
+	\
+	TOKEN(Equal) \
+	TOKEN(NotEqual) \
+	\
+	TOKEN(Assign) \
+	\
+	KEYWORD(And, "and") \
+	KEYWORD(Or, "or") \
+	KEYWORD(Not, "not") \
+	\
+	TOKEN(Eof)
 
 namespace intermediate_rep
 {
+	// Tokens do not own or point to their text, they only know where it is.
+	// The text is resolved through the TokenSource that produced the token.
 	struct Token
 	{
-		enum Type
+		enum Type : std::uint8_t
 		{
-			True,
-			False,
-			While,
-			If,
-			Else,
-			Return,
-
-			Id,
-			IntLit,
-			FloatLit,
-			StrLit,
-
-			OParen,
-			CParen,
-			OSBracket,
-			CSBracket,
-			OCBracket,
-			CCBracket,
-
-			Comma,
-			Semicolon,
-
-			Plus,
-			Minus,
-			Star,
-			Slash,
-
-			Less,
-			LessEqual,
-			Greater,
-			GreaterEqual,
-			
-			Equal,
-			NotEqual,
-
-			Assign,
-			
-			And,
-			Or,
-			Not,
-
-			Eof,
+#define TOKEN_ENUM(name, ...) name,
+			TOKEN_TYPES(TOKEN_ENUM, TOKEN_ENUM)
+#undef TOKEN_ENUM
 		} type;
 
-		std::string lexem;
+		// Byte offset of the lexem in the program text
+		std::uint32_t offset = 0;
+
+		// Literals are decoded and identifiers interned by the lexer,
+		// their lexem length is not stored (see lexem)
+		union
+		{
+			std::uint32_t length = 0;	// all other tokens
+			SymbolId id;				// Id
+			std::int64_t intValue;		// IntLit
+			double floatValue;			// FloatLit
+		};
 	};
 
+	static_assert(sizeof(Token) <= 16);
+
+	// Number of token types, for tables indexed by Token::Type
+#define TOKEN_COUNT(...) + 1
+	inline constexpr std::size_t tokenTypeCount = 0 TOKEN_TYPES(TOKEN_COUNT, TOKEN_COUNT);
+#undef TOKEN_COUNT
+
 	std::string tokenTypeToStr(Token::Type type);
 
-	std::ostream& operator<<(std::ostream& os, const Token& t);
+	// Text of the token inside the program it was lexed from.
+	// Identifiers are looked up in names, the view stays valid as long as the interner.
+	std::string_view lexem(const Token& token, std::string_view program, const Interner& names);
+
+	// Prints (Type, lexem), the lexem only for identifiers and literals
+	std::ostream& print(std::ostream& os, const Token& t, std::string_view text);
 
+	// Sources only have to keep the text of the most recent tokens available
+	inline constexpr std::size_t tokenTextHistory = 4;
+
+	// Anything the parser can pull tokens from.
+	// text(token) has to work for the last tokenTextHistory tokens produced,
+	// the returned view stays valid until the next token is produced (identifiers: see lexem).
+	// names() is the interner the identifier ids refer to.
+	template<typename T>
+	concept TokenSource = requires(T& source, const Token& token)
+	{
+		{ source.next() } -> std::same_as<Token>;
+		{ source.text(token) } -> std::convertible_to<std::string_view>;
+		{ source.names() } -> std::same_as<Interner&>;
+	};
+
+	// Interface for custom token producers, see ProducerSource
 	struct TokenProducer
 	{
 		virtual Token next() = 0;
+		virtual std::string_view text(const Token& token) = 0;
+		virtual Interner& names() = 0;
 		virtual ~TokenProducer(){}
 	};
+
+	// Adapts a TokenProducer to TokenSource, every token costs a virtual call
+	class ProducerSource
+	{
+	public:
+		ProducerSource(TokenProducer* producer):
+			producer{producer}
+		{}
+
+		Token next()
+		{
+			return producer->next();
+		}
+
+		std::string_view text(const Token& token)
+		{
+			return producer->text(token);
+		}
+
+		Interner& names()
+		{
+			return producer->names();
+		}
+
+	private:
+		TokenProducer* producer;
+	};
+
+	static_assert(TokenSource<ProducerSource>);
 }
 
 #endif
\ No newline at end of file
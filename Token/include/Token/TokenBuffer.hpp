@@ -0,0 +1,139 @@
+#ifndef tokenbuffer_hpp
+#define tokenbuffer_hpp
+#include "Token.hpp"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <stdexcept>
+#include <bit>
+#include <algorithm>
+
+namespace intermediate_rep
+{
+	// All tokens of a program stored as struct of arrays.
+	// Offsets and lengths index into source, the program text the tokens were lexed from.
+	// For Id lengths holds the SymbolId in names, for IntLit and FloatLit the index of the decoded value in literals.
+	// clear() keeps the allocated memory, so one buffer can be reused for several compilations.
+	struct TokenBuffer
+	{
+		std::string_view source;
+		Interner* names = nullptr;
+		std::vector<std::uint8_t> types;
+		std::vector<std::uint32_t> offsets;
+		std::vector<std::uint32_t> lengths;
+		std::vector<std::uint64_t> literals;
+
+		void clear()
+		{
+			source = {};
+			names = nullptr;
+			types.clear();
+			offsets.clear();
+			lengths.clear();
+			literals.clear();
+		}
+
+		void push(const Token& token)
+		{
+			types.push_back(static_cast<std::uint8_t>(token.type));
+			offsets.push_back(token.offset);
+			switch(token.type)
+			{
+				case Token::IntLit:
+					lengths.push_back(static_cast<std::uint32_t>(literals.size()));
+					literals.push_back(std::bit_cast<std::uint64_t>(token.intValue));
+					break;
+				case Token::FloatLit:
+					lengths.push_back(static_cast<std::uint32_t>(literals.size()));
+					literals.push_back(std::bit_cast<std::uint64_t>(token.floatValue));
+					break;
+				case Token::Id:
+					lengths.push_back(token.id);
+					break;
+				default:
+					lengths.push_back(token.length);
+					break;
+			}
+		}
+
+		std::size_t size() const
+		{
+			return types.size();
+		}
+
+		Token operator[](std::size_t indx) const
+		{
+			Token token{static_cast<Token::Type>(types[indx]), offsets[indx], lengths[indx]};
+			switch(token.type)
+			{
+				case Token::IntLit:
+					token.intValue = std::bit_cast<std::int64_t>(literals[lengths[indx]]);
+					break;
+				case Token::FloatLit:
+					token.floatValue = std::bit_cast<double>(literals[lengths[indx]]);
+					break;
+				case Token::Id:
+					token.id = lengths[indx];
+					break;
+				default:
+					break;
+			}
+			return token;
+		}
+	};
+
+	// TokenSource over a filled TokenBuffer, advancing is an index increment.
+	// Stays on the final Eof token once it has been reached.
+	class TokenBufferReader
+	{
+	public:
+		TokenBufferReader(const TokenBuffer& buffer):
+			buffer{&buffer}
+		{
+			if(buffer.size() == 0 || buffer.names == nullptr)
+			{
+				throw std::runtime_error("Token buffer has to be filled by a lexer");
+			}
+		}
+
+		Token next()
+		{
+			auto token = (*buffer)[indx];
+			if(indx + 1 < buffer->size())
+			{
+				++indx;
+			}
+			return token;
+		}
+
+		std::string_view text(const Token& token) const
+		{
+			return lexem(token, buffer->source, *buffer->names);
+		}
+
+		Interner& names() const
+		{
+			return *buffer->names;
+		}
+
+		// Index of the token the next call to next() returns
+		std::size_t position() const
+		{
+			return indx;
+		}
+
+		void seek(std::size_t position)
+		{
+			indx = std::min(position, buffer->size() - 1);
+		}
+
+	private:
+		const TokenBuffer* buffer;
+		std::size_t indx = 0;
+	};
+
+	static_assert(TokenSource<TokenBufferReader>);
+}
+
+#endif
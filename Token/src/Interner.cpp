@@ -0,0 +1,83 @@
+#include "Interner.hpp"
+#include <functional>
+#include <algorithm>
+#include <stdexcept>
+
+namespace intermediate_rep
+{
+	Interner::Interner():
+		slots(64, emptySlot)
+	{}
+
+	SymbolId Interner::intern(std::string_view name)
+	{
+		auto hash = std::hash<std::string_view>{}(name);
+		auto mask = slots.size() - 1;
+
+		for(auto slot = hash & mask; ; slot = (slot + 1) & mask)
+		{
+			auto id = slots[slot];
+			if(id == emptySlot)
+			{
+				if(names.size() >= emptySlot)
+				{
+					throw std::runtime_error("Too many identifiers");
+				}
+				id = static_cast<SymbolId>(names.size());
+				names.push_back(store(name));
+				hashes.push_back(hash);
+				slots[slot] = id;
+
+				// Keep the load factor at or below one half
+				if(names.size() * 2 > slots.size())
+				{
+					grow();
+				}
+				return id;
+			}
+			if(hashes[id] == hash && names[id] == name)
+			{
+				return id;
+			}
+		}
+	}
+
+	std::string_view Interner::store(std::string_view name)
+	{
+		if(name.size() > blockSize)
+		{
+			// Oversized names get a block of their own, the current block stays in use
+			auto block = std::make_unique<char[]>(name.size());
+			std::copy(name.begin(), name.end(), block.get());
+			std::string_view stored{block.get(), name.size()};
+			blocks.insert(blocks.end() - (blocks.empty() ? 0 : 1), std::move(block));
+			return stored;
+		}
+
+		if(blockSize - blockUsed < name.size())
+		{
+			blocks.push_back(std::make_unique<char[]>(blockSize));
+			blockUsed = 0;
+		}
+		auto dst = blocks.back().get() + blockUsed;
+		std::copy(name.begin(), name.end(), dst);
+		blockUsed += name.size();
+		return {dst, name.size()};
+	}
+
+	void Interner::grow()
+	{
+		std::vector<SymbolId> bigger(slots.size() * 2, emptySlot);
+		auto mask = bigger.size() - 1;
+		for(SymbolId id = 0; id < names.size(); ++id)
+		{
+			auto slot = hashes[id] & mask;
+			while(bigger[slot] != emptySlot)
+			{
+				slot = (slot + 1) & mask;
+			}
+			bigger[slot] = id;
+		}
+		slots = std::move(bigger);
+	}
+}
@@ -9,81 +9,62 @@ namespace intermediate_rep
 
 		switch(type)
 		{
-			case True:
-				return "True";
-			case False:
-				return "False";
-			case While:
-				return "While";
-			case If:
-				return "If";
-			case Else:
-				return "Else";
-			case Return:
-				return "Return";
-			case Id:
-				return "Id";
-			case IntLit:
-				return "IntLit";
-			case FloatLit:
-				return "FloatLit";
-			case StrLit:
-				return "StrLit";
-			case OParen:
-				return "OParen";
-			case CParen:
-				return "CParen";
-			case OSBracket:
-				return "OSBracket";
-			case CSBracket:
-				return "CSBracket";
-			case OCBracket:
-				return "OCBracket";
-			case CCBracket:
-				return "CCBracket";
-			case Comma:
-				return "Comma";
-			case Semicolon:
-				return "Semicolon";
-			case Plus:
-				return "Plus";
-			case Minus:
-				return "Minus";
-			case Star:
-				return "Star";
-			case Slash:
-				return "Slash";
-			case Less:
-				return "Less";
-			case LessEqual:
-				return "LessEqual";
-			case Greater:
-				return "Greater";
-			case GreaterEqual:
-				return "GreaterEqual";
-			case Equal:
-				return "Equal";
-			case NotEqual:
-				return "NotEqual";
-			case Assign:
-				return "Assign";
-			case And:
-				return "And";
-			case Or:
-				return "Or";
-			case Not:
-				return "Not";
-			case Eof:
-				return "Eof";
+#define TOKEN_CASE(name, ...) case name: return #name;
+			TOKEN_TYPES(TOKEN_CASE, TOKEN_CASE)
+#undef TOKEN_CASE
 			default:
 				throw std::runtime_error("Missing case stmt");
 		}
+	}
+
+	std::string_view lexem(const Token& token, std::string_view program, const Interner& names)
+	{
+		if(token.type == Token::Id)
+		{
+			return names.name(token.id);
+		}
+
+		if(token.type != Token::IntLit && token.type != Token::FloatLit)
+		{
+			return program.substr(token.offset, token.length);
+		}
+
+		// Rescan the literal, the length shares its storage with the value
+		auto isDigit = [program](std::size_t indx)
+		{
+			return indx < program.size() && program[indx] >= '0' && program[indx] <= '9';
+		};
+
+		std::size_t end = token.offset;
+		while(isDigit(end))
+			++end;
 
+		if(token.type == Token::FloatLit)
+		{
+			++end;
+			while(isDigit(end))
+				++end;
+		}
+		return program.substr(token.offset, end - token.offset);
 	}
 
-	std::ostream& operator<<(std::ostream& os, const Token& t)
+	std::ostream& print(std::ostream& os, const Token& t, std::string_view text)
 	{
-		return os << "(" << tokenTypeToStr(t.type) << ", " << t.lexem + ")";
+		using enum Token::Type;
+
+		os << "(" << tokenTypeToStr(t.type) << ", ";
+		switch(t.type)
+		{
+			case Id:
+			case IntLit:
+			case FloatLit:
+			case StrLit:
+				os << text;
+				break;
+			default:
+				break;
+		}
+		return os << ")";
 	}
 
 